@@ -1,5 +1,5 @@
 QT -= gui
-QT += xml
+QT += xml concurrent
 
 CONFIG += c++11 console
 CONFIG -= app_bundle
@@ -9,10 +9,27 @@ HEADERS += \
   src/utils/DmgMounter.hpp \
   src/utils/DsaSignatureGenerator.hpp \
   src/utils/EdDsaSignatureGenerator.hpp \
+  src/utils/DeltaCache.hpp \
   src/utils/DeltaGenerator.hpp \
+  src/utils/DeltaScheduler.hpp \
+  src/utils/DeltaSession.hpp \
+  src/utils/FeedCompressor.hpp \
+  src/utils/FileDigests.hpp \
+  src/utils/MonotonicArena.hpp \
+  src/utils/Rfc822Date.hpp \
+  src/utils/SaveTransaction.hpp \
+  src/utils/SignatureCache.hpp \
+  src/utils/StringPool.hpp \
+  src/utils/Utf8View.hpp \
+  src/utils/XmlByteScanner.hpp \
+  src/utils/XmlScanner.hpp \
   src/ItemEnclosure.hpp \
   src/ItemDelta.hpp \
   src/AppcastItem.hpp \
+  src/AppcastIndex.hpp \
+  src/AppcastModel.hpp \
+  src/AppcastWriter.hpp \
+  src/PlatformFeedFilter.hpp \
   src/Appcast.hpp
 
 SOURCES += \
@@ -20,11 +37,30 @@ SOURCES += \
   src/utils/DmgMounter.cpp \
   src/utils/DsaSignatureGenerator.cpp \
   src/utils/EdDsaSignatureGenerator.cpp \
+  src/utils/DeltaCache.cpp \
   src/utils/DeltaGenerator.cpp \
+  src/utils/DeltaScheduler.cpp \
+  src/utils/DeltaSession.cpp \
+  src/utils/FeedCompressor.cpp \
+  src/utils/FileDigests.cpp \
+  src/utils/MonotonicArena.cpp \
+  src/utils/Rfc822Date.cpp \
+  src/utils/SaveTransaction.cpp \
+  src/utils/SignatureCache.cpp \
+  src/utils/StringPool.cpp \
+  src/utils/Utf8View.cpp \
+  src/utils/XmlByteScanner.cpp \
+  src/utils/XmlScanner.cpp \
   src/ItemEnclosure.cpp \
   src/ItemDelta.cpp \
   src/AppcastItem.cpp \
+  src/AppcastIndex.cpp \
+  src/AppcastModel.cpp \
+  src/AppcastWriter.cpp \
+  src/PlatformFeedFilter.cpp \
   src/Appcast.cpp \
   src/main.cpp
 
 INCLUDEPATH += src
+
+LIBS += -lz -lzstd -lcrypto
@@ -8,23 +8,82 @@
 
 #include "Appcast.hpp"
 
+#include <QDateTime>
+#include <QCryptographicHash>
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
 #include <QDir>
-
+#include <QFuture>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QScopedPointer>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+
+#include "AppcastIndex.hpp"
 #include "AppcastItem.hpp"
+#include "AppcastWriter.hpp"
+#include "PlatformFeedFilter.hpp"
 #include "ItemEnclosure.hpp"
 #include "ItemDelta.hpp"
 #include "utils/DsaSignatureGenerator.hpp"
 #include "utils/EdDsaSignatureGenerator.hpp"
-#include "utils/DeltaGenerator.hpp"
-#include "utils/DmgMounter.hpp"
+#include "utils/FeedCompressor.hpp"
+#include "utils/DeltaScheduler.hpp"
+#include "utils/DeltaSession.hpp"
+#include "utils/SaveTransaction.hpp"
+#include "utils/XmlScanner.hpp"
+
+const int Appcast::PARALLEL_PARSE_MIN_ITEMS = 512;
+
+typedef QPair<qint64, qint64> ItemRange;
+
+struct ItemBatchResult {
+  AppcastModel model;
+  bool success = false;
+};
+
+static bool ParseItemRanges(AppcastModel& theModel, const char* theData, const QVector<ItemRange>& theItemRanges) {
+
+  foreach (const ItemRange& currRange, theItemRanges) {
+
+    XmlScanner xmlScanner(theData, currRange.second);
+    xmlScanner.Seek(currRange.first);
+
+    XmlTag itemTag;
+
+    if (!xmlScanner.ReadNextStartTag(itemTag) || !theModel.ParseItem(xmlScanner, itemTag)) {
+      qWarning().noquote().nospace() << "error parsing appcast item at offset " << currRange.first << " - " << xmlScanner.ErrorString();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static ItemBatchResult ParseItemBatch(const char* theData, const QVector<ItemRange>& theItemRanges) {
+
+  ItemBatchResult batchResult;
+  batchResult.success = ParseItemRanges(batchResult.model, theData, theItemRanges);
+
+  return batchResult;
+}
 
 #pragma mark - Constructors -
 
 #pragma mark Private
 
+Appcast::Appcast(QObject* theParent)
+: QObject(theParent) {
+
+}
+
 Appcast::Appcast(const QDomDocument& theXmlDoc, QObject* theParent)
 : QObject(theParent) {
 
@@ -38,7 +97,9 @@ Appcast* Appcast::FromDocument(const QDomDocument& theXmlDoc, QObject* theParent
 
   Appcast* appcast = new Appcast(theXmlDoc, theParent);
 
-  if (!appcast->ParseXml()) {
+  QXmlStreamReader xmlReader(theXmlDoc.toByteArray(0));
+
+  if (!appcast->ParseXml(xmlReader)) {
     delete appcast;
     appcast = nullptr;
   }
@@ -49,7 +110,6 @@ Appcast* Appcast::FromDocument(const QDomDocument& theXmlDoc, QObject* theParent
 Appcast* Appcast::FromPath(const QString& theFilePath, QObject* theParent) {
 
   Appcast* appcast  = nullptr;
-  QDomDocument appcastDoc;
 
   QFile appcastFile(theFilePath);
 
@@ -60,29 +120,81 @@ Appcast* Appcast::FromPath(const QString& theFilePath, QObject* theParent) {
     qWarning() << "error opening appcast file for reading: " << theFilePath;
   }
   else {
-    if (!appcastDoc.setContent(&appcastFile)) {
+
+    // the model is filled in a single forward pass - the dom is only built later on if the appcast is modified
+    QXmlStreamReader xmlReader(&appcastFile);
+
+    appcast = new Appcast(theParent);
+    appcast->appcastPath = theFilePath;
+
+    if (!appcast->ParseXml(xmlReader)) {
       qWarning() << "error parsing appcast file xml: " << theFilePath;
+      delete appcast;
+      appcast = nullptr;
     }
 
     appcastFile.close();
   }
 
-  if (!appcastDoc.isNull()) {
+  return appcast;
+}
 
-    appcast = new Appcast(appcastDoc, theParent);
+Appcast* Appcast::FromMappedPath(const QString& theFilePath, QObject* theParent) {
 
-    if (!appcast->ParseXml()) {
-      delete appcast;
-      appcast = nullptr;
-    }
+  Appcast* appcast = new Appcast(theParent);
+
+  if (!appcast->MapFile(theFilePath)) {
+    delete appcast;
+    return nullptr;
+  }
+
+  XmlScanner xmlScanner(appcast->mappedData.constData(), appcast->mappedData.size());
+
+  if (!appcast->ParseXml(xmlScanner)) {
+    qWarning() << "error parsing appcast file xml: " << theFilePath;
+    delete appcast;
+    appcast = nullptr;
+  }
+
+  return appcast;
+}
+
+Appcast* Appcast::FromIndexedPath(const QString& theFilePath, QObject* theParent) {
+
+  const AppcastIndex appcastIndex = AppcastIndex::FromPath(theFilePath);
+  if (!appcastIndex.IsValid()) {
+    return nullptr;
+  }
+
+  Appcast* appcast = new Appcast(theParent);
+
+  if (!appcast->MapFile(theFilePath) || appcast->mappedData.size() != appcastIndex.XmlSize() ||
+      appcastIndex.SpliceOffset() < 0 || appcastIndex.SpliceOffset() > appcastIndex.XmlSize()) {
+    delete appcast;
+    return nullptr;
   }
 
+  appcast->appcastPath = theFilePath;
+  appcast->index = appcastIndex;
+  appcast->title = appcastIndex.ChannelTitle();
+  appcast->spliceOffset = appcastIndex.SpliceOffset();
+
   return appcast;
 }
 
 Appcast::~Appcast() {
 
+  // items reference the mapped file, so they must be released before it is unmapped. Destructors still run
+  // for arena allocated facades, but their memory is only returned here, one block at a time
   qDeleteAll(items);
+  items.clear();
+  model.Clear();
+  arena.Release();
+
+  qDeleteAll(archives);
+  archives.clear();
+
+  delete mappedFile;
 }
 
 
@@ -90,38 +202,229 @@ Appcast::~Appcast() {
 
 #pragma mark Private
 
-QString Appcast::TemporaryMountDirForBuild(const qlonglong theBuildNumber) {
+QByteArray Appcast::SplicedXml() const {
 
-  return QString("/tmp/sparkless/%1").arg(theBuildNumber);
+  Q_ASSERT(spliceOffset >= 0 && spliceOffset <= mappedData.size());
+
+  // bytes before and after the splice point are copied untouched
+  QByteArray splicedXml;
+  splicedXml.reserve(mappedData.size() + splicedItemsXml.size());
+  splicedXml.append(mappedData.constData(), static_cast<int>(spliceOffset));
+  splicedXml.append(splicedItemsXml);
+  splicedXml.append(mappedData.constData() + spliceOffset, static_cast<int>(mappedData.size() - spliceOffset));
+
+  return splicedXml;
+}
+
+QString Appcast::ArchivePath(const QString& theAppcastPath, const QString& theShardName) {
+
+  const QFileInfo appcastInfo(theAppcastPath);
+
+  return QString("%1/%2-archive-%3.xml").arg(appcastInfo.absolutePath(), appcastInfo.completeBaseName(), theShardName);
+}
+
+const QList<Appcast*>& Appcast::Archives() const {
+
+  if (archivesLoaded || isArchive || appcastPath.isEmpty()) {
+    return archives;
+  }
+
+  archivesLoaded = true;
+
+  // newest shards first
+  const QFileInfo archivePatternInfo(ArchivePath(appcastPath, "*"));
+  const QStringList archiveFileNames = archivePatternInfo.dir().entryList(QStringList(archivePatternInfo.fileName()), QDir::Files, QDir::Name | QDir::Reversed);
+
+  foreach (const QString& currFileName, archiveFileNames) {
+
+    Appcast* archive = FromMappedPath(archivePatternInfo.dir().filePath(currFileName));
+    if (archive != nullptr) {
+      archive->isArchive = true;
+      archives.append(archive);
+    }
+  }
+
+  return archives;
+}
+
+AppcastItem* Appcast::ItemAt(const int theItemIndex) const {
+
+  AppcastItem* item = items.at(theItemIndex);
+
+  if (item == nullptr && !mappedData.isEmpty()) {
+
+    // the facade is parsed from the record's byte range
+    const AppcastModel::ItemRecord& itemRecord = model.Item(theItemIndex);
+    Appcast* owner = const_cast<Appcast*>(this);
+
+    XmlScanner xmlScanner(mappedData.constData(), itemRecord.offset + itemRecord.length);
+    xmlScanner.Seek(itemRecord.offset);
+
+    XmlTag itemTag;
+    MonotonicArena::Scope arenaScope(&owner->arena);
+
+    if (xmlScanner.ReadNextStartTag(itemTag) && itemTag.name == "item") {
+      item = AppcastItem::FromScanner(xmlScanner, &owner->stringPool, owner);
+    }
+
+    items[theItemIndex] = item;
+  }
+
+  return item;
+}
+
+int Appcast::ParseIndexedItem(const qlonglong theBuildVersion) const {
+
+  const AppcastIndex::ItemEntry* itemEntry = index.Entry(theBuildVersion);
+  if (itemEntry == nullptr) {
+    return -1;
+  }
+
+  // only the item's byte range is parsed - the rest of the feed is never touched
+  XmlScanner xmlScanner(mappedData.constData(), itemEntry->offset + itemEntry->length);
+  xmlScanner.Seek(itemEntry->offset);
+
+  XmlTag itemTag;
+  Appcast* owner = const_cast<Appcast*>(this);
+
+  if (!xmlScanner.ReadNextStartTag(itemTag) || itemTag.name != "item" || !owner->model.ParseItem(xmlScanner, itemTag)) {
+    return -1;
+  }
+
+  items.append(nullptr);
+
+  return model.ItemCount() - 1;
 }
 
 #pragma mark Public
 
+const QList<AppcastItem*>& Appcast::Items() const {
+
+  for (int itemIndex = 0; itemIndex < items.count(); itemIndex++) {
+    ItemAt(itemIndex);
+  }
+
+  return items;
+}
+
 AppcastItem* Appcast::Item(const qlonglong theBuildVersion) const {
 
-  if (theBuildVersion < 0) {
-    return nullptr;
+  int itemIndex = model.IndexOf(theBuildVersion);
+  if (itemIndex < 0) {
+    itemIndex = ParseIndexedItem(theBuildVersion);
+  }
+  if (itemIndex >= 0) {
+    return ItemAt(itemIndex);
+  }
+
+  // builds moved out of the live feed by Archive() still resolve (e.g. as delta sources)
+  foreach (Appcast* currArchive, Archives()) {
+
+    AppcastItem* item = currArchive->Item(theBuildVersion);
+    if (item != nullptr) {
+      return item;
+    }
   }
 
-  return itemHash.value(theBuildVersion);
+  return nullptr;
 }
 
 bool Appcast::Contains(const qlonglong theBuildVersion) const {
 
-  return itemHash.value(theBuildVersion) != nullptr;
+  if (model.Contains(theBuildVersion) || index.Contains(theBuildVersion)) {
+    return true;
+  }
+
+  foreach (Appcast* currArchive, Archives()) {
+    if (currArchive->Contains(theBuildVersion)) {
+      return true;
+    }
+  }
+
+  return false;
 }
 
 bool Appcast::ContainsEnclosure(const qlonglong theBuildVersion, const EnclosurePlatform thePlatform) const {
 
-  AppcastItem* item = Item(theBuildVersion);
-  if (item != nullptr) {
+  if (model.ContainsEnclosure(theBuildVersion, thePlatform) || index.ContainsEnclosure(theBuildVersion, thePlatform)) {
+    return true;
+  }
 
-    return item->HasEnclosure(thePlatform);
+  foreach (Appcast* currArchive, Archives()) {
+    if (currArchive->ContainsEnclosure(theBuildVersion, thePlatform)) {
+      return true;
+    }
   }
 
   return false;
 }
 
+QVector<qlonglong> Appcast::PreviousBuilds(const qlonglong theBuildVersion, const EnclosurePlatform thePlatform, const int theMaxCount) const {
+
+  QVector<qlonglong> builds = model.BuildsBefore(theBuildVersion, thePlatform, theMaxCount);
+
+  // indexed appcasts only hold the items parsed so far in their model, the index knows every build
+  if (index.IsValid()) {
+    builds += index.BuildsBefore(theBuildVersion, thePlatform, theMaxCount);
+  }
+  else if (Archives().isEmpty()) {
+    return builds;
+  }
+
+  // each source already returns its newest theMaxCount predecessors, so the merged result only needs truncating
+  foreach (Appcast* currArchive, Archives()) {
+    builds += currArchive->PreviousBuilds(theBuildVersion, thePlatform, theMaxCount);
+  }
+
+  std::sort(builds.begin(), builds.end(), std::greater<qlonglong>());
+  builds.erase(std::unique(builds.begin(), builds.end()), builds.end());
+
+  if (theMaxCount >= 0 && builds.count() > theMaxCount) {
+    builds.resize(theMaxCount);
+  }
+
+  return builds;
+}
+
+QString Appcast::ReleasePathForBuild(const qlonglong theBuildVersion, const EnclosurePlatform thePlatform) const {
+
+  QUrl fileUrl;
+
+  const AppcastIndex::ItemEntry* itemEntry = index.Entry(theBuildVersion);
+  const AppcastIndex::EnclosureEntry* enclosureEntry = index.FullEnclosure(theBuildVersion, thePlatform);
+
+  // indexed appcasts only scan the enclosure's own tag
+  if (enclosureEntry != nullptr) {
+
+    const qint64 enclosureOffset = itemEntry->offset + enclosureEntry->offset;
+
+    XmlScanner xmlScanner(mappedData.constData(), enclosureOffset + enclosureEntry->length);
+    xmlScanner.Seek(enclosureOffset);
+
+    XmlTag enclosureTag;
+    if (xmlScanner.ReadNextStartTag(enclosureTag) && enclosureTag.name == "enclosure") {
+      fileUrl = QUrl(enclosureTag.Attribute("url").ToString());
+    }
+  }
+  else {
+
+    AppcastItem* item = Item(theBuildVersion);
+    ItemEnclosure* enclosure = (item != nullptr) ? item->Enclosure(thePlatform) : nullptr;
+
+    if (enclosure != nullptr) {
+      fileUrl = enclosure->FileUrl();
+    }
+  }
+
+  if (!fileUrl.fileName().toLower().endsWith(".dmg")) {
+    return QString();
+  }
+
+  const QString releasePath = MapRemoteUrlToLocalMirrorPath(fileUrl.toString());
+
+  return QFileInfo::exists(releasePath) ? releasePath : QString();
+}
+
 const QString Appcast::S3BaseUrl() const {
 
   QString s3Endpoint;
@@ -186,12 +489,18 @@ const QString Appcast::MapLocalMirrorPathToRemoteUrl(const QString& theMirrorPat
 
 void Appcast::PrintItems() const {
 
-  foreach (AppcastItem* currItem, items) {
+  for (int itemIndex = 0; itemIndex < model.ItemCount(); itemIndex++) {
+
+    // facades that have already been created may carry changes the records don't
+    AppcastItem* currItem = items.at(itemIndex);
 
     if (currItem != nullptr) {
       currItem->Print();
 //      qDebug() << MapRemoteUrlToLocalMirrorPath(currItem->Enclosures().first()->FileUrl().toString());
     }
+    else {
+      model.PrintItem(itemIndex);
+    }
   }
 }
 
@@ -199,40 +508,358 @@ void Appcast::PrintItems() const {
 
 #pragma mark Private
 
-bool Appcast::ParseXml() {
+bool Appcast::ParseXml(QXmlStreamReader& theReader) {
+
+  // sparkle appcasts are matched on their qualified names (e.g. 'sparkle:deltas')
+  theReader.setNamespaceProcessing(false);
 
-  if (appcastDoc.isNull()) {
+  if (!theReader.readNextStartElement() || theReader.qualifiedName() != QLatin1String("rss")) {
+    qWarning().noquote().nospace() << "error parsing appcast xml - missing <rss> element";
     return false;
   }
-  
-  QDomElement rssElement = appcastDoc.firstChildElement("rss");
-  QDomElement channelElement = rssElement.firstChildElement("channel");
 
-  QDomElement titleElement = channelElement.firstChildElement("title");
-  title = titleElement.firstChild().nodeValue();
+  while (theReader.readNextStartElement()) {
 
-  QDomElement itemElement = channelElement.firstChildElement("item");
+    if (theReader.qualifiedName() != QLatin1String("channel")) {
+      theReader.skipCurrentElement();
+      continue;
+    }
 
-  while (!itemElement.isNull()) {
+    while (theReader.readNextStartElement()) {
 
-    AppcastItem* item = AppcastItem::FromElement(itemElement, this);
+      if (theReader.qualifiedName() == QLatin1String("title") && title.isNull()) {
+        title = theReader.readElementText(QXmlStreamReader::IncludeChildElements);
+      }
+      else if (theReader.qualifiedName() == QLatin1String("item")) {
 
-    if (item != nullptr) {
+        AppcastItem* item = AppcastItem::FromReader(theReader, &stringPool, this);
+
+        if (item != nullptr) {
+          model.AppendItem(item);
+          items.append(item);
+        }
+      }
+      else {
+        theReader.skipCurrentElement();
+      }
+    }
+  }
+
+  if (theReader.hasError()) {
+    qWarning().noquote().nospace() << "error parsing appcast xml - " << theReader.errorString() << " (line " << theReader.lineNumber() << ")";
+    return false;
+  }
+
+  return true;
+}
 
-      items.append(item);
+bool Appcast::ParseXml(XmlScanner& theScanner) {
 
-      if (item->VersionBuild() >= 0) {
-        itemHash.insert(item->VersionBuild(), item);
+  XmlTag rssTag;
+
+  if (!theScanner.ReadNextStartTag(rssTag) || rssTag.name != "rss") {
+    qWarning().noquote().nospace() << "error parsing appcast xml - missing <rss> element";
+    return false;
+  }
+
+  QVector<ItemRange> itemRanges;
+  XmlTag channelTag;
+
+  while (theScanner.ReadNextStartTag(channelTag)) {
+
+    if (channelTag.name != "channel" || channelTag.selfClosing) {
+      theScanner.SkipElement(channelTag);
+      continue;
+    }
+
+    XmlTag currTag;
+
+    while (theScanner.ReadNextStartTag(currTag)) {
+
+      if (currTag.name == "title" && title.isNull()) {
+        title = theScanner.ReadElementText(currTag);
+      }
+      else if (currTag.name == "language" && spliceOffset < 0) {
+        theScanner.SkipElement(currTag);
+        spliceOffset = theScanner.Position();
+      }
+      else if (currTag.name == "item" && !currTag.selfClosing) {
+
+        // items are only located here and parsed into records afterwards, see ParseItems()
+        if (!theScanner.SkipUnnestedElement(currTag)) {
+          break;
+        }
+
+        itemRanges.append(ItemRange(currTag.begin, theScanner.Position()));
+      }
+      else {
+        theScanner.SkipElement(currTag);
+      }
+    }
+
+    // without a <language> element new items are appended to the end of the channel
+    if (spliceOffset < 0 && currTag.closing && currTag.name == "channel") {
+      spliceOffset = currTag.begin;
+    }
+  }
+
+  if (theScanner.HasError()) {
+    qWarning().noquote().nospace() << "error parsing appcast xml - " << theScanner.ErrorString();
+    return false;
+  }
+
+  return ParseItems(theScanner.Data(), itemRanges);
+}
+
+bool Appcast::ParseItems(const char* theData, const QVector<ItemRange>& theItemRanges) {
+
+  const int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+
+  if (theItemRanges.count() < PARALLEL_PARSE_MIN_ITEMS || threadCount < 2) {
+
+    if (!ParseItemRanges(model, theData, theItemRanges)) {
+      return false;
+    }
+  }
+  else {
+
+    // contiguous batches (a few per thread to even out item sizes), merged back in document order. Workers
+    // only produce plain records - facades are QObjects and have to be created on this thread
+    const int batchCount = qMin(theItemRanges.count(), threadCount * 4);
+    QList<QFuture<ItemBatchResult>> batchFutures;
+
+    for (int batchIndex = 0; batchIndex < batchCount; batchIndex++) {
+
+      const int rangesBegin = static_cast<int>(static_cast<qint64>(theItemRanges.count()) * batchIndex / batchCount);
+      const int rangesEnd = static_cast<int>(static_cast<qint64>(theItemRanges.count()) * (batchIndex + 1) / batchCount);
+
+      batchFutures.append(QtConcurrent::run(ParseItemBatch, theData, theItemRanges.mid(rangesBegin, rangesEnd - rangesBegin)));
+    }
+
+    bool success = true;
+
+    for (int batchIndex = 0; batchIndex < batchFutures.count(); batchIndex++) {
+
+      const ItemBatchResult batchResult = batchFutures[batchIndex].result();
+
+      if (success && batchResult.success) {
+        model.Append(batchResult.model);
       }
+      else {
+        success = false;
+      }
+    }
+
+    if (!success) {
+      return false;
+    }
+  }
+
+  while (items.count() < model.ItemCount()) {
+    items.append(nullptr);
+  }
+
+  return true;
+}
+
+bool Appcast::MapFile(const QString& theFilePath) {
+
+  if (!QFileInfo::exists(theFilePath)) {
+    qWarning().noquote().nospace() << "error - appcast file doesn't exist: " << theFilePath;
+    return false;
+  }
+
+  appcastPath = theFilePath;
+  mappedFile = new QFile(theFilePath, this);
+
+  // opened without QIODevice::Text so that the mapped bytes match the file exactly
+  if (!mappedFile->open(QIODevice::ReadOnly)) {
+    qWarning() << "error opening appcast file for reading: " << theFilePath;
+    return false;
+  }
+
+  const qint64 fileSize = mappedFile->size();
+  uchar* fileData = (fileSize > 0) ? mappedFile->map(0, fileSize) : nullptr;
+
+  if (fileData != nullptr) {
+    mappedData = QByteArray::fromRawData(reinterpret_cast<const char*>(fileData), static_cast<int>(fileSize));
+  }
+  else {
+    // not every file system supports mapping, fallback to a regular read
+    mappedData = mappedFile->readAll();
+  }
+
+  return true;
+}
+
+bool Appcast::LoadXml(const QByteArray& theXml) {
+
+  mappedData = theXml;
+
+  XmlScanner xmlScanner(mappedData.constData(), mappedData.size());
+
+  return ParseXml(xmlScanner);
+}
+
+bool Appcast::LoadDocument() {
+
+  if (!appcastDoc.isNull()) {
+    return true;
+  }
+
+  if (!mappedData.isEmpty()) {
+
+    if (!appcastDoc.setContent(mappedData)) {
+      qWarning() << "error parsing appcast file xml: " << appcastPath;
+      appcastDoc = QDomDocument();
+    }
+
+    return !appcastDoc.isNull();
+  }
+
+  if (appcastPath.isEmpty()) {
+    return false;
+  }
+
+  QFile appcastFile(appcastPath);
+
+  if (!appcastFile.open(QIODevice::ReadOnly| QIODevice::Text)) {
+    qWarning() << "error opening appcast file for reading: " << appcastPath;
+    return false;
+  }
+
+  if (!appcastDoc.setContent(&appcastFile)) {
+    qWarning() << "error parsing appcast file xml: " << appcastPath;
+    appcastDoc = QDomDocument();
+  }
+
+  appcastFile.close();
+
+  return !appcastDoc.isNull();
+}
+
+void Appcast::SpliceItemXml(const QByteArray& theItemXml) {
+
+  Q_ASSERT(spliceOffset >= 0);
+
+  // each item is inserted at the same point, so the most recently spliced item comes first
+  splicedItemsXml.prepend(theItemXml);
+  splicedItemsXml.prepend('\n');
+}
+
+bool Appcast::AddCompressedFeedsToTransaction(SaveTransaction& theTransaction, const QList<QPair<QString, QByteArray> >& theFeedFiles) const {
+
+  QList<FeedCompressor::Format> formats;
+  formats << FeedCompressor::GzipFormat << FeedCompressor::ZstdFormat;
+
+  // every file/format pair is compressed on its own pool thread (zstd additionally splits large feeds itself)
+  QList<QFuture<QByteArray> > compressionFutures;
+  QStringList compressedPaths;
+
+  for (int feedIndex = 0; feedIndex < theFeedFiles.count(); feedIndex++) {
+    foreach (const FeedCompressor::Format currFormat, formats) {
+      compressionFutures.append(QtConcurrent::run(FeedCompressor::Compress, theFeedFiles.at(feedIndex).second, currFormat, compressionLevel));
+      compressedPaths.append(theFeedFiles.at(feedIndex).first + FeedCompressor::Extension(currFormat));
+    }
+  }
+
+  bool success = true;
+
+  for (int futureIndex = 0; futureIndex < compressionFutures.count(); futureIndex++) {
+
+    const QByteArray compressedData = compressionFutures[futureIndex].result();
+
+    if (compressedData.isNull()) {
+      qWarning().noquote().nospace() << "error compressing appcast file: " << compressedPaths.at(futureIndex);
+      success = false;
+    }
+    else {
+      theTransaction.AddFile(compressedPaths.at(futureIndex), compressedData);
+    }
+  }
+
+  return success;
+}
+
+bool Appcast::AddFeedToTransaction(SaveTransaction& theTransaction, const QString& theFilePath, const QByteArray& theXml, const qint64 theModifiedTime) const {
+
+  // sidecars are published before the feed itself
+  if (writesIndex) {
+    theTransaction.AddFile(AppcastIndex::IndexPathForAppcast(theFilePath), AppcastIndex::FromXml(theXml, theModifiedTime).Serialize());
+  }
+
+  // the feed itself is published last
+  QList<QPair<QString, QByteArray> > feedFiles;
+
+  if (writesPlatformFeeds) {
+
+    QVector<EnclosurePlatform> platforms;
+    platforms << MacPlatform << WindowsPlatform;
+
+    // the feed is serialized once, every platform's copy is filtered from it in the same scan
+    const QVector<QByteArray> platformFeeds = PlatformFeedFilter::Filter(theXml, platforms);
+    if (platformFeeds.count() != platforms.count()) {
+      qWarning().noquote().nospace() << "error creating platform appcasts for: " << theFilePath;
+      return false;
     }
 
-    itemElement = itemElement.nextSiblingElement("item");
+    for (int platformIndex = 0; platformIndex < platforms.count(); platformIndex++) {
+      feedFiles.append(qMakePair(PlatformFeedFilter::FeedPathForPlatform(theFilePath, platforms.at(platformIndex)), platformFeeds.at(platformIndex)));
+    }
+  }
+
+  feedFiles.append(qMakePair(theFilePath, theXml));
+
+  // compressed copies are published before the xml they were made from
+  if (writesCompressedFeeds && !AddCompressedFeedsToTransaction(theTransaction, feedFiles)) {
+    return false;
+  }
+
+  for (int feedIndex = 0; feedIndex < feedFiles.count(); feedIndex++) {
+    theTransaction.AddFile(feedFiles.at(feedIndex).first, feedFiles.at(feedIndex).second);
   }
 
   return true;
 }
 
-ItemEnclosure* Appcast::AddEnclosureToItemWithSignature(AppcastItem* theItem, const QString& theFilePath, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType) {
+void Appcast::AddManifestToTransaction(SaveTransaction& theTransaction, const QString& theFilePath) const {
+
+  // sorted by file name and without timestamps, so the manifest itself is byte-stable too. The index embeds the
+  // save time and is a local lookup cache rather than a published file, so it is left out
+  const QString indexPath = AppcastIndex::IndexPathForAppcast(theFilePath);
+  QMap<QString, QJsonObject> fileEntries;
+
+  for (int fileIndex = 0; fileIndex < theTransaction.Count(); fileIndex++) {
+
+    if (theTransaction.FilePath(fileIndex) == indexPath) {
+      continue;
+    }
+
+    const QByteArray& fileData = theTransaction.FileData(fileIndex);
+    const QString fileName = QFileInfo(theTransaction.FilePath(fileIndex)).fileName();
+
+    QJsonObject fileEntry;
+    fileEntry.insert("path", fileName);
+    fileEntry.insert("size", static_cast<double>(fileData.size()));
+    fileEntry.insert("sha256", QString::fromLatin1(QCryptographicHash::hash(fileData, QCryptographicHash::Sha256).toHex()));
+    fileEntry.insert("etag", QString("\"%1\"").arg(QString::fromLatin1(QCryptographicHash::hash(fileData, QCryptographicHash::Md5).toHex())));
+
+    fileEntries.insert(fileName, fileEntry);
+  }
+
+  QJsonArray fileArray;
+  foreach (const QJsonObject& currEntry, fileEntries) {
+    fileArray.append(currEntry);
+  }
+
+  QJsonObject manifest;
+  manifest.insert("files", fileArray);
+
+  // published last - once it is visible, every file it lists is in place
+  theTransaction.AddFile(theFilePath + ".manifest.json", QJsonDocument(manifest).toJson(QJsonDocument::Indented));
+}
+
+ItemEnclosure* Appcast::AddEnclosureToItemWithSignature(AppcastItem* theItem, const QString& theFilePath, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, const qlonglong theFileLength) {
 
 //  qDebug() << "AddEnclosureToItemWithSignature("<<theFilePath<<")";
 
@@ -243,7 +870,7 @@ ItemEnclosure* Appcast::AddEnclosureToItemWithSignature(AppcastItem* theItem, co
 
   QFileInfo fileInfo(theFilePath);
 
-  const qlonglong fileLength = fileInfo.size();
+  const qlonglong fileLength = (theFileLength >= 0) ? theFileLength : fileInfo.size();
   const QString fileName = fileInfo.fileName();
   const QUrl fileUrl = UrlForRelease(fileName, thePlatform);
 
@@ -252,6 +879,24 @@ ItemEnclosure* Appcast::AddEnclosureToItemWithSignature(AppcastItem* theItem, co
   return enclosure;
 }
 
+ItemDelta* Appcast::AddDeltaToItemWithSignature(AppcastItem* theItem, const qlonglong thePrevVersion, const QString& theFilePath, const QByteArray& theSignature) {
+
+  if (theItem == nullptr) {
+    qWarning().noquote().nospace() << "error adding delta to item - item is NULL";
+    return nullptr;
+  }
+
+  QFileInfo fileInfo(theFilePath);
+
+  const qlonglong fileLength = fileInfo.size();
+  const QString fileName = fileInfo.fileName();
+  const QUrl fileUrl = UrlForDelta(fileName, theItem->VersionBuild(), MacPlatform);
+//  qDebug() << "delta url: " << fileUrl.toString();
+
+  ItemDelta* delta = theItem->AddDelta(thePrevVersion, fileLength, fileUrl, MacPlatform, theSignature, Ed25519Signature);
+  return delta;
+}
+
 #pragma mark Public
 
 void Appcast::SetS3Region(const QString& theS3Region) {
@@ -279,9 +924,34 @@ void Appcast::SetUrlPrefix(const QString& theUrlPrefix) {
   urlPrefix = theUrlPrefix;
 }
 
+void Appcast::SetWritesIndex(const bool theWritesIndex) {
+
+  writesIndex = theWritesIndex;
+}
+
+void Appcast::SetWritesPlatformFeeds(const bool theWritesPlatformFeeds) {
+
+  writesPlatformFeeds = theWritesPlatformFeeds;
+}
+
+void Appcast::SetWritesCompressedFeeds(const bool theWritesCompressedFeeds) {
+
+  writesCompressedFeeds = theWritesCompressedFeeds;
+}
+
+void Appcast::SetCompressionLevel(const int theLevel) {
+
+  compressionLevel = theLevel;
+}
+
+void Appcast::SetWritesManifest(const bool theWritesManifest) {
+
+  writesManifest = theWritesManifest;
+}
+
 AppcastItem* Appcast::CreateItem(const QString& theVersionDescription, const qlonglong theVersionBuild) {
 
-  AppcastItem* newItem = AppcastItem::NewItem(theVersionDescription, theVersionBuild, this);
+  AppcastItem* newItem = AppcastItem::NewItem(theVersionDescription, theVersionBuild, &stringPool, this);
   if (newItem != nullptr) {
     newItem->SetTitle(title);
   }
@@ -289,85 +959,66 @@ AppcastItem* Appcast::CreateItem(const QString& theVersionDescription, const qlo
   return newItem;
 }
 
-ItemDelta* Appcast::CreateDeltaForBuild(const qlonglong theOldBuildNumber, const QString theNewReleasePath, AppcastItem* theNewItem, const EnclosurePlatform thePlatform, const QByteArray& theEdDsaKey) {
+QList<ItemDelta*> Appcast::CreateDeltasForBuilds(const QVector<qlonglong>& theOldBuildNumbers, DeltaScheduler& theScheduler, AppcastItem* theNewItem, const EnclosurePlatform thePlatform) {
 
   Q_ASSERT(theNewItem != nullptr);
-  Q_ASSERT(!theNewReleasePath.isEmpty());
-  Q_ASSERT(theOldBuildNumber >= 0);
-  Q_ASSERT(theNewItem->VersionBuild() >= 0);
+  Q_ASSERT(theNewItem->VersionBuild() == theScheduler.Session()->NewBuildNumber());
   Q_ASSERT(thePlatform != NullPlatform);
 
+  QList<ItemDelta*> newDeltas;
+
   // temp. enforce .dmg only
-  if (!theNewReleasePath.toLower().endsWith(".dmg")) {
-    return nullptr;
+  if (!theScheduler.Session()->NewReleasePath().toLower().endsWith(".dmg")) {
+    return newDeltas;
   }
 
   // temp. enforce deltas on macOS only
   if (thePlatform != MacPlatform) {
-    return nullptr;
+    return newDeltas;
   }
 
-  ItemDelta* newDelta = nullptr;
+  // the old releases are resolved first, so that builds without a local dmg never cost a mount
+  QVector<DeltaScheduler::Job> deltaJobs;
 
-  const qlonglong newBuildNumber = theNewItem->VersionBuild();
+  foreach (const qlonglong currOldBuildNumber, theOldBuildNumbers) {
 
-  const QString newReleaseMountPoint = TemporaryMountDirForBuild(newBuildNumber);
-  QDir().mkpath(newReleaseMountPoint);
+    DeltaScheduler::Job deltaJob;
+    deltaJob.oldBuildNumber = currOldBuildNumber;
+    deltaJob.oldReleasePath = ReleasePathForBuild(currOldBuildNumber, thePlatform);
 
-//  qDebug() << "mounting new release '" << theNewReleasePath << "' to '" << newReleaseMountPoint << "'.";
-
-  DmgMounter newReleaseMounter(theNewReleasePath, newReleaseMountPoint);
-  if (!newReleaseMounter.Mount()) {
-    qWarning() << "failed to mount image for delta generation: " << newReleaseMounter.ImagePath();
-    return nullptr;
+    if (!deltaJob.oldReleasePath.isEmpty()) {
+      deltaJobs.append(deltaJob);
+    }
   }
 
-  AppcastItem* oldItem = Item(theOldBuildNumber);
-  if (oldItem != nullptr) {
-
-    ItemEnclosure* oldEnclosure = oldItem->Enclosure(thePlatform);
-    if (oldEnclosure != nullptr && oldEnclosure->FileUrl().fileName().toLower().endsWith(".dmg")) {
-
-      const QString oldReleasePath = MapRemoteUrlToLocalMirrorPath(oldEnclosure->FileUrl().toString());
-
-      if (QFileInfo::exists(oldReleasePath)) {
+  const QVector<DeltaScheduler::Result> deltaResults = theScheduler.Run(deltaJobs);
 
-        const QString oldReleaseMountPoint = TemporaryMountDirForBuild(theOldBuildNumber);
-        QDir().mkpath(oldReleaseMountPoint);
+  // attached in the order the builds were passed in, whichever order the jobs finished in
+  foreach (const DeltaScheduler::Result& currResult, deltaResults) {
 
-//        qDebug() << "mounting old release '" << oldReleasePath << "' to '" << oldReleaseMountPoint << "'.";
-
-        DmgMounter oldReleaseMounter(oldReleasePath, oldReleaseMountPoint);
-        if (!oldReleaseMounter.Mount()) {
-          qWarning() << "failed to mount image for delta generation: " << oldReleaseMounter.ImagePath();
-          return nullptr;
-        }
+    if (!currResult.success) {
+      continue;
+    }
 
-        qInfo().noquote().nospace() << "Generating delta for build " << theOldBuildNumber << " -> " << newBuildNumber << "...";
+    ItemDelta* newDelta = AddDeltaToItemWithSignature(theNewItem, currResult.oldBuildNumber, currResult.deltaPath, currResult.signature);
+    if (newDelta != nullptr) {
+      newDeltas.append(newDelta);
+    }
+  }
 
-        const QString oldReleaseBundlePath = QString("%1/%2.app").arg(oldReleaseMountPoint, title);
-        const QString newReleaseBundlePath = QString("%1/%2.app").arg(newReleaseMountPoint, title);
-        const QString deltaDir = QString("%1/deltas/%2").arg(QFileInfo(theNewReleasePath).dir().absolutePath()).arg(newBuildNumber);
-        const QString deltaFilename = QString("%1.%2.%3.delta").arg(title).arg(theOldBuildNumber).arg(newBuildNumber);
-        const QString deltaPath = QString("%1/%2").arg(deltaDir).arg(deltaFilename);
-//        qDebug() << "path for delta: " << deltaPath;
+  return newDeltas;
+}
 
-        QDir().mkpath(deltaDir);
+ItemDelta* Appcast::CreateDeltaForBuild(const qlonglong theOldBuildNumber, DeltaSession& theSession, AppcastItem* theNewItem, const EnclosurePlatform thePlatform, const QByteArray& theEdDsaKey, DeltaCache* theCache) {
 
-        DeltaGenerator deltaGenerator(oldReleaseBundlePath, newReleaseBundlePath, deltaPath);
-        if (!deltaGenerator.Success()) {
-          qFatal("failed to make delta: %s", deltaPath.toUtf8().constData());
-        }
+  Q_ASSERT(theOldBuildNumber >= 0);
 
-        newReleaseMounter.Unmount();
-        oldReleaseMounter.Unmount();
+  DeltaScheduler deltaScheduler(&theSession, theEdDsaKey);
+  deltaScheduler.SetCache(theCache);
 
-        newDelta = AddDeltaToIem(theNewItem, theOldBuildNumber, deltaPath, theEdDsaKey);
-      }
-    }
-  }
+  const QList<ItemDelta*> newDeltas = CreateDeltasForBuilds(QVector<qlonglong>() << theOldBuildNumber, deltaScheduler, theNewItem, thePlatform);
 
-  return newDelta;
+  return newDeltas.isEmpty() ? nullptr : newDeltas.first();
 }
 
 ItemEnclosure* Appcast::AddEnclosureToIem(AppcastItem* theItem, const QString& theFilePath, const EnclosurePlatform thePlatform, const QString& theDsaKeyPath) {
@@ -378,7 +1029,7 @@ ItemEnclosure* Appcast::AddEnclosureToIem(AppcastItem* theItem, const QString& t
     return nullptr;
   }
 
-  return AddEnclosureToItemWithSignature(theItem, theFilePath, thePlatform, signatureGenerator.Signature(), DsaSignature);
+  return AddEnclosureToItemWithSignature(theItem, theFilePath, thePlatform, signatureGenerator.Signature(), DsaSignature, signatureGenerator.BinarySize());
 }
 
 ItemEnclosure* Appcast::AddEnclosureToIem(AppcastItem* theItem, const QString& theFilePath, const EnclosurePlatform thePlatform, const QByteArray& theEdDsaKey) {
@@ -400,114 +1051,237 @@ ItemDelta* Appcast::AddDeltaToIem(AppcastItem* theItem, const qlonglong thePrevV
     return nullptr;
   }
 
-  QFileInfo fileInfo(theFilePath);
-
-  const qlonglong fileLength = fileInfo.size();
-  const QString fileName = fileInfo.fileName();
-  const QUrl fileUrl = UrlForDelta(fileName, theItem->VersionBuild(), MacPlatform);
-//  qDebug() << "delta url: " << fileUrl.toString();
-
-  ItemDelta* delta = theItem->AddDelta(thePrevVersion, fileLength, fileUrl, MacPlatform, signatureGenerator.Signature(), Ed25519Signature);
-  return delta;
+  return AddDeltaToItemWithSignature(theItem, thePrevVersion, theFilePath, signatureGenerator.Signature());
 }
 
 
 
 bool Appcast::Save(const QString& theFilePath) {
 
-  if (appcastDoc.isNull()) {
+  if (theFilePath.isEmpty()) {
+    qWarning().noquote().nospace() << "error saving appcast - specified save path is empty in Save() method";
     return false;
   }
 
-  if (theFilePath.isEmpty()) {
-    qWarning().noquote().nospace() << "error saving appcast - specified save path is empty in Save() method";
+  QByteArray appcastXml;
+
+  if (spliceOffset >= 0) {
+    appcastXml = SplicedXml();
+  }
+  else if (LoadDocument()) {
+    appcastXml = AppcastWriter::DocumentXml(appcastDoc);
+  }
+  else {
     return false;
   }
 
-  QFile appcastFile(theFilePath);
+  // published via temp file + rename so that a crash mid-save can never leave a truncated feed behind
+  SaveTransaction saveTransaction;
 
-  if (!appcastFile.open(QIODevice::ReadWrite| QIODevice::Truncate)) {
-    qWarning() << "error opening appcast file for saving: " << theFilePath;
+  // the index records the xml's mtime, so it is pinned for every file in the transaction
+  const qint64 modifiedTime = QDateTime::currentMSecsSinceEpoch();
+  saveTransaction.SetModifiedTime(modifiedTime);
+
+  if (!AddFeedToTransaction(saveTransaction, theFilePath, appcastXml, modifiedTime)) {
     return false;
   }
 
-  QTextStream textStream(&appcastFile);
-  appcastDoc.save(textStream, 0);
-  appcastFile.close();
+  if (writesManifest) {
+    AddManifestToTransaction(saveTransaction, theFilePath);
+  }
+
+  if (!saveTransaction.Commit()) {
+    qWarning() << "error saving appcast file: " << theFilePath;
+    return false;
+  }
 
   qInfo().noquote().nospace() << "successfully saved appcast file: " << theFilePath;
 
   return true;
 }
 
-bool Appcast::AddItem(AppcastItem* theItem) {
-
-  if (theItem == nullptr) { qWarning() << "Appcast::AddItem() failed - specified item is NULL"; return false; }
-  if (theItem->Title().isEmpty()) { qWarning() << "Appcast::AddItem() failed - item's title is empty"; return false; }
-  if (theItem->PublishedTimestamp().isNull()) { qWarning() << "Appcast::AddItem() failed - item's published timestamp is null"; return false; }
+bool Appcast::Archive(const int theKeepCount, const QDateTime& theKeepSince) {
 
+  if (mappedData.isEmpty() || spliceOffset < 0 || index.IsValid()) {
+    qWarning().noquote().nospace() << "error archiving appcast items - the appcast must be read with FromMappedPath()";
+    return false;
+  }
+  if (!splicedItemsXml.isEmpty()) {
+    qWarning().noquote().nospace() << "error archiving appcast items - the appcast has unsaved items";
+    return false;
+  }
 
-  QDomElement itemElement = appcastDoc.createElement("item");
+  // newest builds first
+  QVector<int> itemIndexes;
+  itemIndexes.reserve(model.ItemCount());
 
-  {
-    QDomElement itemTitleElement = appcastDoc.createElement("title");
-    QDomText itemTitleValue = appcastDoc.createTextNode(theItem->Title());
-    itemTitleElement.appendChild(itemTitleValue);
-    itemElement.appendChild(itemTitleElement);
+  for (int itemIndex = 0; itemIndex < model.ItemCount(); itemIndex++) {
+    if (model.Item(itemIndex).build >= 0) {
+      itemIndexes.append(itemIndex);
+    }
   }
 
-  {
-    QDomElement itemPublishedDateElement = appcastDoc.createElement("pubDate");
-    QDomText itemPublishedDateValue = appcastDoc.createTextNode(theItem->PublishedTimestampString());
-    itemPublishedDateElement.appendChild(itemPublishedDateValue);
-    itemElement.appendChild(itemPublishedDateElement);
-  }
+  const AppcastModel& appcastModel = model;
+  std::stable_sort(itemIndexes.begin(), itemIndexes.end(), [&appcastModel](const int theLhs, const int theRhs) {
+    return appcastModel.Item(theLhs).build > appcastModel.Item(theRhs).build;
+  });
 
-  if (!theItem->Description().isEmpty()) {
-    QDomElement itemDescriptionElement = appcastDoc.createElement("description");
-    QDomText itemDescriptionValue = appcastDoc.createTextNode(theItem->Description());
-    itemDescriptionElement.appendChild(itemDescriptionValue);
-    itemElement.appendChild(itemDescriptionElement);
+  // shard year -> archived item indexes, newest first
+  QMap<int, QVector<int> > shardItemIndexes;
+  QVector<int> archivedIndexes;
+
+  for (int rank = 0; rank < itemIndexes.count(); rank++) {
+
+    const AppcastModel::ItemRecord& itemRecord = model.Item(itemIndexes.at(rank));
+    const QDateTime publishedTimestamp = AppcastItem::TimestampFromUtf8(itemRecord.pubDate.Data(), itemRecord.pubDate.Size());
+
+    // items without a valid pubDate can't be assigned to a shard, so they always stay in the live feed
+    const bool keptByCount = (theKeepCount >= 0 && rank < theKeepCount);
+    const bool keptByDate = (theKeepSince.isValid() && publishedTimestamp >= theKeepSince);
+
+    if (keptByCount || keptByDate || !publishedTimestamp.isValid()) {
+      continue;
+    }
+
+    shardItemIndexes[publishedTimestamp.date().year()].append(itemIndexes.at(rank));
+    archivedIndexes.append(itemIndexes.at(rank));
   }
 
-  if (!theItem->ReleaseNotesUrl().isEmpty()) {
-    QDomElement itemReleaseNotesElement = appcastDoc.createElement("sparkle:releaseNotesLink");
-    QDomText itemReleaseNotesValue = appcastDoc.createTextNode(theItem->ReleaseNotesUrl().toString());
-    itemReleaseNotesElement.appendChild(itemReleaseNotesValue);
-    itemElement.appendChild(itemReleaseNotesElement);
+  if (archivedIndexes.isEmpty()) {
+    qInfo().noquote().nospace() << "no appcast items to archive";
+    return true;
   }
 
-  foreach (ItemEnclosure* currEnclosure, theItem->Enclosures()) {
+  // new shards reuse the live feed's xml declaration and <rss> start tag (and with it the namespace declarations)
+  XmlScanner xmlScanner(mappedData.constData(), mappedData.size());
+  XmlTag rssTag;
+  xmlScanner.ReadNextStartTag(rssTag);
+
+  const QByteArray shardProlog = mappedData.left(static_cast<int>(rssTag.end));
 
-    if (currEnclosure == nullptr) { qWarning() << "Appcast::AddItem() failed - the item has a null enclosure object"; return false; }
+  SaveTransaction saveTransaction;
 
-    QDomElement itemEnclosureElement = appcastDoc.createElement("enclosure");
-    if (currEnclosure->Serialize(itemEnclosureElement)) {
-      itemElement.appendChild(itemEnclosureElement);
+  const qint64 modifiedTime = QDateTime::currentMSecsSinceEpoch();
+  saveTransaction.SetModifiedTime(modifiedTime);
+
+  // shards are published before the live feed, so an interrupted run can leave an item in both places but never in neither
+  QMapIterator<int, QVector<int> > shardIter(shardItemIndexes);
+
+  while (shardIter.hasNext()) {
+
+    shardIter.next();
+
+    const QString shardPath = ArchivePath(appcastPath, QString::number(shardIter.key()));
+    QScopedPointer<Appcast> shard;
+
+    if (QFileInfo::exists(shardPath)) {
+      shard.reset(FromMappedPath(shardPath));
     }
-  }
+    else {
+
+      QByteArray shardXml = shardProlog;
+      shardXml.append("\n<channel>\n<title>");
+      shardXml.append(title.toHtmlEscaped().toUtf8());
+      shardXml.append("</title>\n</channel>\n</rss>\n");
 
-  if (!theItem->Deltas().isEmpty()) {
+      shard.reset(new Appcast());
+      if (!shard->LoadXml(shardXml)) {
+        shard.reset();
+      }
+    }
+
+    if (shard.isNull()) {
+      qWarning().noquote().nospace() << "error archiving appcast items - unable to read archive: " << shardPath;
+      return false;
+    }
 
-    QDomElement deltasElement = appcastDoc.createElement("sparkle:deltas");
+    // shards are append-only: items are copied verbatim and builds the shard already has are left alone
+    const QVector<int>& currItemIndexes = shardIter.value();
 
-    foreach (ItemDelta* currDelta, theItem->Deltas()) {
+    for (int index = currItemIndexes.count() - 1; index >= 0; index--) {
 
-      if (currDelta == nullptr) { qWarning() << "Appcast::AddItem() failed - the item has a null delta object"; return false; }
+      const AppcastModel::ItemRecord& itemRecord = model.Item(currItemIndexes.at(index));
 
-      // add <enclosure> to <sparkle:deltas>
-      QDomElement deltaEnclosureElement = appcastDoc.createElement("enclosure");
-      if (currDelta->Serialize(deltaEnclosureElement)) {
-        deltasElement.appendChild(deltaEnclosureElement);
+      if (!shard->model.Contains(itemRecord.build)) {
+        shard->SpliceItemXml(QByteArray(mappedData.constData() + itemRecord.offset, static_cast<int>(itemRecord.length)));
       }
     }
 
-    // add <sparkle:deltas> to <item>
-    if (!deltasElement.firstChildElement("enclosure").isNull()) {
-      itemElement.appendChild(deltasElement);
+    if (!shard->splicedItemsXml.isEmpty()) {
+      saveTransaction.AddFile(shardPath, shard->SplicedXml());
+    }
+  }
+
+  // the live feed is the original bytes minus each archived item (and the whitespace leading up to it)
+  std::sort(archivedIndexes.begin(), archivedIndexes.end(), [&appcastModel](const int theLhs, const int theRhs) {
+    return appcastModel.Item(theLhs).offset < appcastModel.Item(theRhs).offset;
+  });
+
+  QByteArray appcastXml;
+  appcastXml.reserve(mappedData.size());
+
+  qint64 copiedOffset = 0;
+
+  foreach (const int currItemIndex, archivedIndexes) {
+
+    const AppcastModel::ItemRecord& itemRecord = model.Item(currItemIndex);
+
+    qint64 cutOffset = itemRecord.offset;
+    while (cutOffset > copiedOffset && QChar::isSpace(static_cast<uchar>(mappedData.at(static_cast<int>(cutOffset - 1))))) {
+      cutOffset--;
     }
+
+    appcastXml.append(mappedData.constData() + copiedOffset, static_cast<int>(cutOffset - copiedOffset));
+    copiedOffset = itemRecord.offset + itemRecord.length;
+  }
+
+  appcastXml.append(mappedData.constData() + copiedOffset, static_cast<int>(mappedData.size() - copiedOffset));
+
+  if (!AddFeedToTransaction(saveTransaction, appcastPath, appcastXml, modifiedTime)) {
+    return false;
+  }
+
+  if (writesManifest) {
+    AddManifestToTransaction(saveTransaction, appcastPath);
+  }
+
+  if (!saveTransaction.Commit()) {
+    qWarning() << "error saving archived appcast file: " << appcastPath;
+    return false;
+  }
+
+  qInfo().noquote().nospace() << "successfully archived " << archivedIndexes.count() << " items into " << shardItemIndexes.count() << " archive(s)";
+
+  return true;
+}
+
+bool Appcast::AddItem(AppcastItem* theItem) {
+
+  if (theItem == nullptr) { qWarning() << "Appcast::AddItem() failed - specified item is NULL"; return false; }
+  if (theItem->Title().isEmpty()) { qWarning() << "Appcast::AddItem() failed - item's title is empty"; return false; }
+  if (theItem->PublishedTimestamp().isNull()) { qWarning() << "Appcast::AddItem() failed - item's published timestamp is null"; return false; }
+
+  const QByteArray itemXml = AppcastWriter::ItemXml(theItem);
+  if (itemXml.isNull()) {
+    return false;
   }
 
+  // mapped appcasts are saved by splicing the new item into the original bytes
+  if (spliceOffset >= 0) {
+
+    // inserted directly after <language>
+    SpliceItemXml(itemXml);
+
+    return true;
+  }
+
+  if (!LoadDocument()) { qWarning() << "Appcast::AddItem() failed - unable to load appcast document"; return false; }
+
+  QDomDocument itemDoc;
+  if (!itemDoc.setContent(itemXml)) { qWarning() << "Appcast::AddItem() failed - unable to parse serialized item"; return false; }
+
+  const QDomNode itemElement = appcastDoc.importNode(itemDoc.documentElement(), true);
+
   QDomElement rssElement = appcastDoc.firstChildElement("rss");
   QDomElement channelElement = rssElement.firstChildElement("channel");
 
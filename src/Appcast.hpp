@@ -13,7 +13,20 @@
 #include <QDomDocument>
 #include <QHash>
 
+#include "AppcastIndex.hpp"
+#include "AppcastModel.hpp"
 #include "Constants.hpp"
+#include "utils/MonotonicArena.hpp"
+#include "utils/StringPool.hpp"
+
+class QDateTime;
+class QFile;
+class QXmlStreamReader;
+class DeltaCache;
+class DeltaScheduler;
+class DeltaSession;
+class SaveTransaction;
+class XmlScanner;
 
 class ItemEnclosure;
 class ItemDelta;
@@ -24,12 +37,34 @@ class Appcast : public QObject {
 
 private:
 
+  QString appcastPath;
   QDomDocument appcastDoc;
 
+  // set when read via FromMappedPath() - enclosures keep views into this buffer for the lifetime of the appcast
+  QFile* mappedFile = nullptr;
+  QByteArray mappedData;
+
+  // byte offset in mappedData where added items are spliced in on save (after the channel's <language>)
+  qint64 spliceOffset = -1;
+  QByteArray splicedItemsXml;
+
+  // shared by every item/enclosure of this appcast
+  StringPool stringPool;
+
+  // backing memory for the item/enclosure facades of mapped appcasts, released in one go with the appcast
+  MonotonicArena arena;
+
   QString title;
 
-  QList<AppcastItem*> items;
-  QHash<qlonglong, AppcastItem*> itemHash;
+  // flat records used for lookups and feed-wide scans
+  AppcastModel model;
+
+  // item facades, parallel to the model's item records. Mapped appcasts only create them on first access
+  mutable QList<AppcastItem*> items;
+
+  // set when read via FromIndexedPath() - lookups are answered from it, and an item's byte range is only parsed
+  // into the model once the item itself is accessed
+  AppcastIndex index;
 
   QString s3Region;
   QString s3BucketName;
@@ -38,12 +73,27 @@ private:
 
   QString urlPrefix;
 
+  bool writesIndex = false;
+  bool writesPlatformFeeds = false;
+  bool writesCompressedFeeds = false;
+  bool writesManifest = false;
+  int compressionLevel = -1;
+
+  // year shards written by Archive(), only loaded once a build can't be found in the live feed
+  mutable QList<Appcast*> archives;
+  mutable bool archivesLoaded = false;
+  bool isArchive = false;
+
+  // mapped appcasts with at least this many items parse them on the global thread pool
+  static const int PARALLEL_PARSE_MIN_ITEMS;
+
 
 #pragma mark - Constructors -
 
 #pragma mark Private
 private:
 
+  Appcast(QObject* theParent = nullptr);
   Appcast(const QDomDocument&, QObject* theParent = nullptr);
 
 #pragma mark Public
@@ -51,6 +101,9 @@ public:
 
   static Appcast* FromDocument(const QDomDocument&, QObject* theParent = nullptr);
   static Appcast* FromPath(const QString&, QObject* theParent = nullptr);
+  static Appcast* FromMappedPath(const QString&, QObject* theParent = nullptr);
+  // nullptr if the appcast has no valid index sidecar
+  static Appcast* FromIndexedPath(const QString&, QObject* theParent = nullptr);
 
   virtual ~Appcast() Q_DECL_OVERRIDE;
 
@@ -60,12 +113,21 @@ public:
 #pragma mark Private
 private:
 
-  QString TemporaryMountDirForBuild(const qlonglong);
+  QByteArray SplicedXml() const;
+
+  static QString ArchivePath(const QString& theAppcastPath, const QString& theShardName);
+  const QList<Appcast*>& Archives() const;
+
+  AppcastItem* ItemAt(const int theItemIndex) const;
+  // parses an indexed item's byte range into the model, returns its item index or -1
+  int ParseIndexedItem(const qlonglong theBuildVersion) const;
 
 #pragma mark Public
 public:
 
-  const QList<AppcastItem*>& Items() const { return items; }
+  // indexed appcasts only hold the items that have been looked up so far
+  const QList<AppcastItem*>& Items() const;
+  const AppcastModel& Model() const { return model; }
 
   const QString& Title() const { return title; }
 
@@ -79,9 +141,19 @@ public:
 
   const QString& UrlPrefix() const { return urlPrefix; }
 
+  bool WritesIndex() const { return writesIndex; }
+
+  // archives included, like Item(). Indexed appcasts answer both from the index without parsing anything
   bool Contains(const qlonglong theBuildVersion) const;
   bool ContainsEnclosure(const qlonglong theBuildVersion, const EnclosurePlatform) const;
 
+  // up to theMaxCount (-1 for all) candidate builds for delta generation, newest first. Only builds with a full
+  // enclosure for the platform are returned, archives included
+  QVector<qlonglong> PreviousBuilds(const qlonglong theBuildVersion, const EnclosurePlatform, const int theMaxCount = -1) const;
+
+  // the build's dmg in the local s3 mirror, or an empty string if it has none
+  QString ReleasePathForBuild(const qlonglong theBuildVersion, const EnclosurePlatform) const;
+
   const QString UrlForRelease(const QString& theReleaseFileName, const EnclosurePlatform thePlatform) const;
   const QString UrlForDelta(const QString& theDeltaFileName, const qlonglong theNewBuildVersion, const EnclosurePlatform thePlatform) const;
 
@@ -96,9 +168,21 @@ public:
 #pragma mark Private
 private:
 
-  bool ParseXml();
+  bool ParseXml(QXmlStreamReader&);
+  bool ParseXml(XmlScanner&);
+  bool ParseItems(const char* theData, const QVector<QPair<qint64, qint64>>& theItemRanges);
+  bool MapFile(const QString&);
+  bool LoadDocument();
+  bool LoadXml(const QByteArray&);
 
-  ItemEnclosure* AddEnclosureToItemWithSignature(AppcastItem* theItem, const QString& theFilePath, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType);
+  void SpliceItemXml(const QByteArray& theItemXml);
+  bool AddCompressedFeedsToTransaction(SaveTransaction&, const QList<QPair<QString, QByteArray> >& theFeedFiles) const;
+  bool AddFeedToTransaction(SaveTransaction&, const QString& theFilePath, const QByteArray& theXml, const qint64 theModifiedTime) const;
+  void AddManifestToTransaction(SaveTransaction&, const QString& theFilePath) const;
+
+  ItemDelta* AddDeltaToItemWithSignature(AppcastItem* theItem, const qlonglong thePrevVersion, const QString& theFilePath, const QByteArray& theSignature);
+  // theFileLength is taken from the file itself when -1
+  ItemEnclosure* AddEnclosureToItemWithSignature(AppcastItem* theItem, const QString& theFilePath, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, const qlonglong theFileLength = -1);
 
 #pragma mark Public
 public:
@@ -110,8 +194,27 @@ public:
 
   void SetUrlPrefix(const QString&);
 
+  void SetWritesIndex(const bool);
+
+  // also publish <appcast>-macos.xml and <appcast>-windows.xml next to the appcast on save (see PlatformFeedFilter)
+  void SetWritesPlatformFeeds(const bool);
+
+  // also publish .gz and .zst copies of every written feed, theLevel is clamped per format (-1 selects each
+  // format's maximum), see FeedCompressor
+  void SetWritesCompressedFeeds(const bool);
+  void SetCompressionLevel(const int theLevel);
+
+  // also publish <appcast>.manifest.json, listing the size, sha-256 and etag (md5, as computed by s3 for single
+  // part uploads) of every file written alongside it - so publishing can skip unchanged uploads/invalidations
+  void SetWritesManifest(const bool);
+
   AppcastItem* CreateItem(const QString& theVersionDescription, const qlonglong theVersionBuild);
-  ItemDelta* CreateDeltaForBuild(const qlonglong theOldBuildNumber, const QString theNewReleasePath, AppcastItem* theNewItem, const EnclosurePlatform thePlatform, const QByteArray& theEdDsaKey);
+  // theScheduler's new release must be theNewItem's. Deltas are generated concurrently (see DeltaScheduler) and
+  // attached in the order of theOldBuildNumbers, builds without a local dmg in the mirror are skipped
+  QList<ItemDelta*> CreateDeltasForBuilds(const QVector<qlonglong>& theOldBuildNumbers, DeltaScheduler& theScheduler, AppcastItem* theNewItem, const EnclosurePlatform thePlatform);
+
+  // theSession's new release must be theNewItem's. theCache (optional) is checked before anything is mounted
+  ItemDelta* CreateDeltaForBuild(const qlonglong theOldBuildNumber, DeltaSession& theSession, AppcastItem* theNewItem, const EnclosurePlatform thePlatform, const QByteArray& theEdDsaKey, DeltaCache* theCache = nullptr);
 
   ItemEnclosure* AddEnclosureToIem(AppcastItem* theItem, const QString& theFilePath, const EnclosurePlatform thePlatform, const QString& theDsaKeyPath);
   ItemEnclosure* AddEnclosureToIem(AppcastItem* theItem, const QString& theFilePath, const EnclosurePlatform thePlatform, const QByteArray& theEdDsaKey);
@@ -120,6 +223,11 @@ public:
 
   bool Save(const QString& theFilePath);
 
+  // moves every item that is neither among the newest theKeepCount builds nor published since theKeepSince into
+  // per-year archive shards next to the appcast (append-only), then rewrites the appcast without them. Pass -1 /
+  // an invalid date to ignore either criterion. Requires an appcast read with FromMappedPath()
+  bool Archive(const int theKeepCount, const QDateTime& theKeepSince);
+
   bool AddItem(AppcastItem*);
 
 
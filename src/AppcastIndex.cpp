@@ -0,0 +1,340 @@
+//
+//  AppcastIndex.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "AppcastIndex.hpp"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+
+#include "AppcastModel.hpp"
+#include "ItemEnclosure.hpp"
+#include "utils/XmlScanner.hpp"
+
+const quint32 AppcastIndex::MAGIC = 0x53504b49; // 'SPKI'
+const quint16 AppcastIndex::FORMAT_VERSION = 3;
+
+static bool EntryBuildLessThan(const AppcastIndex::ItemEntry& theLeft, const AppcastIndex::ItemEntry& theRight) {
+
+  return theLeft.build < theRight.build;
+}
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+
+AppcastIndex::AppcastIndex() {
+
+}
+
+AppcastIndex AppcastIndex::FromXml(const QByteArray& theXml, const qint64 theModifiedTime) {
+
+  AppcastIndex index;
+  index.xmlSize = theXml.size();
+  index.xmlModifiedTime = theModifiedTime;
+  index.xmlHash = QCryptographicHash::hash(theXml, QCryptographicHash::Sha256);
+
+  XmlScanner xmlScanner(theXml.constData(), theXml.size());
+  XmlTag currTag;
+
+  while (xmlScanner.ReadNextTag(currTag)) {
+
+    // item contents are consumed below, so only channel level tags get here
+    if (currTag.closing) {
+      if (currTag.name == "channel" && index.spliceOffset < 0) {
+        index.spliceOffset = currTag.begin;
+      }
+      continue;
+    }
+    if (currTag.selfClosing) {
+      continue;
+    }
+
+    if (currTag.name == "title" && index.channelTitle.isNull()) {
+      index.channelTitle = xmlScanner.ReadElementText(currTag);
+      continue;
+    }
+    if (currTag.name == "language" && index.spliceOffset < 0) {
+      xmlScanner.SkipElement(currTag);
+      index.spliceOffset = xmlScanner.Position();
+      continue;
+    }
+    if (currTag.name != "item") {
+      continue;
+    }
+
+    ItemEntry itemEntry;
+    itemEntry.offset = currTag.begin;
+
+    XmlTag innerTag;
+    int depth = 1;
+    bool inDeltas = false;
+
+    while (depth > 0 && xmlScanner.ReadNextTag(innerTag)) {
+
+      if (innerTag.closing) {
+        depth--;
+        if (innerTag.name == "sparkle:deltas") {
+          inDeltas = false;
+        }
+        continue;
+      }
+
+      if (!innerTag.selfClosing) {
+        depth++;
+      }
+
+      if (innerTag.name == "sparkle:deltas") {
+        inDeltas = !innerTag.selfClosing;
+      }
+      else if (innerTag.name == "enclosure") {
+
+        EnclosureEntry enclosureEntry;
+        enclosureEntry.offset = static_cast<quint32>(innerTag.begin - itemEntry.offset);
+        enclosureEntry.length = static_cast<quint32>(innerTag.end - innerTag.begin);
+        enclosureEntry.platform = ItemEnclosure::PlatformFromXmlValue(innerTag.Attribute("sparkle:os").ToString());
+
+        if (inDeltas) {
+          enclosureEntry.deltaFrom = innerTag.Attribute("sparkle:deltaFrom").ToLongLong();
+        }
+        else {
+          itemEntry.platformMask |= AppcastModel::PlatformBit(enclosureEntry.platform);
+
+          // same rule as AppcastItem - the item's build comes from its first (non-delta) enclosure
+          if (itemEntry.build < 0) {
+            itemEntry.build = innerTag.Attribute("sparkle:version").ToLongLong();
+          }
+        }
+
+        itemEntry.enclosureMask |= AppcastModel::PlatformBit(enclosureEntry.platform);
+        itemEntry.enclosures.append(enclosureEntry);
+      }
+    }
+
+    itemEntry.length = xmlScanner.Position() - itemEntry.offset;
+
+    if (itemEntry.build >= 0) {
+      index.entries.append(itemEntry);
+    }
+  }
+
+  std::stable_sort(index.entries.begin(), index.entries.end(), EntryBuildLessThan);
+
+  // duplicate builds resolve to the last item in document order (matching Appcast's item hash)
+  QVector<ItemEntry> uniqueEntries;
+  uniqueEntries.reserve(index.entries.count());
+
+  for (int entryIndex = 0; entryIndex < index.entries.count(); entryIndex++) {
+
+    if (!uniqueEntries.isEmpty() && uniqueEntries.last().build == index.entries.at(entryIndex).build) {
+      uniqueEntries.last() = index.entries.at(entryIndex);
+    }
+    else {
+      uniqueEntries.append(index.entries.at(entryIndex));
+    }
+  }
+  index.entries = uniqueEntries;
+
+  return index;
+}
+
+AppcastIndex AppcastIndex::FromPath(const QString& theAppcastPath, const bool theVerifyHash) {
+
+  AppcastIndex index;
+
+  QFile indexFile(IndexPathForAppcast(theAppcastPath));
+  if (!indexFile.open(QIODevice::ReadOnly)) {
+    return index;
+  }
+
+  QDataStream indexStream(&indexFile);
+  indexStream.setVersion(QDataStream::Qt_5_0);
+
+  quint32 magic = 0;
+  quint16 formatVersion = 0;
+  quint32 entryCount = 0;
+
+  indexStream >> magic >> formatVersion;
+  if (magic != MAGIC || formatVersion != FORMAT_VERSION) {
+    qWarning().noquote().nospace() << "ignoring appcast index with unknown format: " << indexFile.fileName();
+    return index;
+  }
+
+  qint64 xmlSize = -1;
+  qint64 xmlModifiedTime = -1;
+  QByteArray xmlHash;
+  QString channelTitle;
+  qint64 spliceOffset = -1;
+
+  indexStream >> xmlSize >> xmlModifiedTime >> xmlHash >> channelTitle >> spliceOffset >> entryCount;
+
+  const QFileInfo appcastInfo(theAppcastPath);
+  if (appcastInfo.size() != xmlSize || appcastInfo.lastModified().toMSecsSinceEpoch() != xmlModifiedTime) {
+    qWarning().noquote().nospace() << "ignoring stale appcast index: " << indexFile.fileName();
+    return index;
+  }
+
+  QVector<ItemEntry> entries;
+  entries.reserve(static_cast<int>(qMin<quint32>(entryCount, 1u << 20)));
+
+  for (quint32 entryIndex = 0; entryIndex < entryCount && indexStream.status() == QDataStream::Ok; entryIndex++) {
+
+    ItemEntry itemEntry;
+    quint32 enclosureCount = 0;
+
+    indexStream >> itemEntry.build >> itemEntry.offset >> itemEntry.length >> itemEntry.platformMask >> itemEntry.enclosureMask >> enclosureCount;
+
+    for (quint32 enclosureIndex = 0; enclosureIndex < enclosureCount && indexStream.status() == QDataStream::Ok; enclosureIndex++) {
+
+      EnclosureEntry enclosureEntry;
+      quint8 platform = 0;
+
+      indexStream >> enclosureEntry.offset >> enclosureEntry.length >> platform >> enclosureEntry.deltaFrom;
+      enclosureEntry.platform = static_cast<EnclosurePlatform>(platform);
+
+      itemEntry.enclosures.append(enclosureEntry);
+    }
+
+    entries.append(itemEntry);
+  }
+
+  if (indexStream.status() != QDataStream::Ok) {
+    qWarning().noquote().nospace() << "ignoring corrupt appcast index: " << indexFile.fileName();
+    return index;
+  }
+
+  if (theVerifyHash) {
+
+    QFile appcastFile(theAppcastPath);
+    if (!appcastFile.open(QIODevice::ReadOnly)) {
+      return index;
+    }
+
+    QCryptographicHash appcastHash(QCryptographicHash::Sha256);
+    const uchar* appcastData = (xmlSize > 0) ? appcastFile.map(0, xmlSize) : nullptr;
+
+    if (appcastData != nullptr) {
+      appcastHash.addData(reinterpret_cast<const char*>(appcastData), static_cast<int>(xmlSize));
+    }
+    else {
+      appcastHash.addData(&appcastFile);
+    }
+
+    if (appcastHash.result() != xmlHash) {
+      qWarning().noquote().nospace() << "ignoring stale appcast index (content changed): " << indexFile.fileName();
+      return index;
+    }
+  }
+
+  index.xmlSize = xmlSize;
+  index.xmlModifiedTime = xmlModifiedTime;
+  index.xmlHash = xmlHash;
+  index.channelTitle = channelTitle;
+  index.spliceOffset = spliceOffset;
+  index.entries = entries;
+
+  return index;
+}
+
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+
+QString AppcastIndex::IndexPathForAppcast(const QString& theAppcastPath) {
+
+  return theAppcastPath + ".idx";
+}
+
+const AppcastIndex::ItemEntry* AppcastIndex::Entry(const qlonglong theBuildVersion) const {
+
+  ItemEntry searchEntry;
+  searchEntry.build = theBuildVersion;
+
+  QVector<ItemEntry>::const_iterator entryIter = std::lower_bound(entries.constBegin(), entries.constEnd(), searchEntry, EntryBuildLessThan);
+
+  if (entryIter != entries.constEnd() && entryIter->build == theBuildVersion) {
+    return &(*entryIter);
+  }
+
+  return nullptr;
+}
+
+bool AppcastIndex::ContainsEnclosure(const qlonglong theBuildVersion, const EnclosurePlatform thePlatform) const {
+
+  const ItemEntry* itemEntry = Entry(theBuildVersion);
+
+  return itemEntry != nullptr && (itemEntry->enclosureMask & AppcastModel::PlatformBit(thePlatform)) != 0;
+}
+
+const AppcastIndex::EnclosureEntry* AppcastIndex::FullEnclosure(const qlonglong theBuildVersion, const EnclosurePlatform thePlatform) const {
+
+  const ItemEntry* itemEntry = Entry(theBuildVersion);
+  if (itemEntry == nullptr) {
+    return nullptr;
+  }
+
+  for (int enclosureIndex = 0; enclosureIndex < itemEntry->enclosures.count(); enclosureIndex++) {
+
+    const EnclosureEntry& currEnclosure = itemEntry->enclosures.at(enclosureIndex);
+
+    if (currEnclosure.deltaFrom < 0 && currEnclosure.platform == thePlatform) {
+      return &currEnclosure;
+    }
+  }
+
+  return nullptr;
+}
+
+QVector<qlonglong> AppcastIndex::BuildsBefore(const qlonglong theBuildVersion, const EnclosurePlatform thePlatform, const int theMaxCount) const {
+
+  ItemEntry searchEntry;
+  searchEntry.build = theBuildVersion;
+
+  // entries are sorted and unique by build, everything before the first build >= theBuildVersion is a predecessor
+  QVector<ItemEntry>::const_iterator entryIter = std::lower_bound(entries.constBegin(), entries.constEnd(), searchEntry, EntryBuildLessThan);
+
+  QVector<qlonglong> predecessors;
+
+  while (entryIter != entries.constBegin() && (theMaxCount < 0 || predecessors.count() < theMaxCount)) {
+
+    entryIter--;
+
+    if ((entryIter->platformMask & AppcastModel::PlatformBit(thePlatform)) != 0) {
+      predecessors.append(entryIter->build);
+    }
+  }
+
+  return predecessors;
+}
+
+QByteArray AppcastIndex::Serialize() const {
+
+  QByteArray indexData;
+  QDataStream indexStream(&indexData, QIODevice::WriteOnly);
+  indexStream.setVersion(QDataStream::Qt_5_0);
+
+  indexStream << MAGIC << FORMAT_VERSION;
+  indexStream << xmlSize << xmlModifiedTime << xmlHash << channelTitle << spliceOffset << static_cast<quint32>(entries.count());
+
+  foreach (const ItemEntry& currEntry, entries) {
+
+    indexStream << currEntry.build << currEntry.offset << currEntry.length << currEntry.platformMask << currEntry.enclosureMask << static_cast<quint32>(currEntry.enclosures.count());
+
+    foreach (const EnclosureEntry& currEnclosure, currEntry.enclosures) {
+      indexStream << currEnclosure.offset << currEnclosure.length << static_cast<quint8>(currEnclosure.platform) << currEnclosure.deltaFrom;
+    }
+  }
+
+  return indexData;
+}
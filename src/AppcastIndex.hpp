@@ -0,0 +1,104 @@
+//
+//  AppcastIndex.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef AppcastIndex_hpp
+#define AppcastIndex_hpp
+
+#include <QObject>
+#include <QVector>
+
+#include "Constants.hpp"
+
+// compact binary sidecar (appcast.xml.idx) mapping build numbers to byte ranges within the appcast xml, along
+// with each item's platforms and the byte ranges of its enclosures/deltas, so that build lookups and enclosure
+// checks don't require the xml to be parsed. The channel title and the offset new items are spliced in at are
+// kept as well, so items can be added without parsing the feed either. An index is only valid for the exact xml it was built from - the
+// xml's size and modification time are checked on load, its sha-256 only on request.
+class AppcastIndex {
+
+public:
+
+  struct EnclosureEntry {
+    quint32 offset = 0;           // relative to the item's offset
+    quint32 length = 0;
+    EnclosurePlatform platform = NullPlatform;
+    qlonglong deltaFrom = -1;     // -1 for full enclosures
+  };
+
+  struct ItemEntry {
+    qlonglong build = -1;
+    qint64 offset = -1;
+    qint64 length = 0;
+    quint8 platformMask = 0;      // platforms with a full (non-delta) enclosure, as in AppcastModel
+    quint8 enclosureMask = 0;     // platforms with any enclosure, deltas included
+    QVector<EnclosureEntry> enclosures;
+  };
+
+private:
+
+  static const quint32 MAGIC;
+  static const quint16 FORMAT_VERSION;
+
+  qint64 xmlSize = -1;
+  qint64 xmlModifiedTime = -1;
+  QByteArray xmlHash;
+
+  QString channelTitle;
+  qint64 spliceOffset = -1;
+
+  // sorted by build
+  QVector<ItemEntry> entries;
+
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+public:
+
+  AppcastIndex();
+
+  static AppcastIndex FromXml(const QByteArray& theXml, const qint64 theModifiedTime);
+  // theVerifyHash additionally hashes the whole xml, which makes the lookup O(feed size)
+  static AppcastIndex FromPath(const QString& theAppcastPath, const bool theVerifyHash = false);
+
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+public:
+
+  static QString IndexPathForAppcast(const QString& theAppcastPath);
+
+  bool IsValid() const { return xmlSize >= 0; }
+
+  qint64 XmlSize() const { return xmlSize; }
+  qint64 XmlModifiedTime() const { return xmlModifiedTime; }
+  const QByteArray& XmlHash() const { return xmlHash; }
+
+  const QString& ChannelTitle() const { return channelTitle; }
+  // same rule as Appcast - directly after <language>, else before </channel>
+  qint64 SpliceOffset() const { return spliceOffset; }
+
+  const QVector<ItemEntry>& Entries() const { return entries; }
+  const ItemEntry* Entry(const qlonglong theBuildVersion) const;
+
+  bool Contains(const qlonglong theBuildVersion) const { return Entry(theBuildVersion) != nullptr; }
+  // same semantics as AppcastModel::ContainsEnclosure() - deltas count
+  bool ContainsEnclosure(const qlonglong theBuildVersion, const EnclosurePlatform) const;
+
+  // the item's first full enclosure for the platform, or nullptr
+  const EnclosureEntry* FullEnclosure(const qlonglong theBuildVersion, const EnclosurePlatform) const;
+
+  // same semantics as AppcastModel::BuildsBefore()
+  QVector<qlonglong> BuildsBefore(const qlonglong theBuildVersion, const EnclosurePlatform, const int theMaxCount = -1) const;
+
+  QByteArray Serialize() const;
+
+};
+
+#endif /* AppcastIndex_hpp */
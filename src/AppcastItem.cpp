@@ -9,32 +9,42 @@
 #include "AppcastItem.hpp"
 
 #include <QDebug>
+#include <QXmlStreamReader>
 
 #include "ItemEnclosure.hpp"
 #include "ItemDelta.hpp"
+#include "utils/Rfc822Date.hpp"
+#include "utils/StringPool.hpp"
+#include "utils/XmlScanner.hpp"
 
 #pragma mark - Constructors -
 
 #pragma mark Private
 
-AppcastItem::AppcastItem(QObject* theParent)
-: QObject(theParent) {
+AppcastItem::AppcastItem(StringPool* theStringPool, QObject* theParent)
+: QObject(theParent), stringPool(theStringPool) {
 
 }
 
-AppcastItem::AppcastItem(const QDomElement& theItemElement, QObject* theParent)
-: QObject(theParent) {
+#pragma mark Public
 
-  itemElement = theItemElement;
-}
+AppcastItem* AppcastItem::FromReader(QXmlStreamReader& theReader, StringPool* theStringPool, QObject* theParent) {
 
-#pragma mark Public
+  AppcastItem* item = new AppcastItem(theStringPool, theParent);
 
-AppcastItem* AppcastItem::FromElement(const QDomElement& theItemElement, QObject* theParent) {
+  if (!item->ParseXml(theReader)) {
+    delete item;
+    item = nullptr;
+  }
 
-  AppcastItem* item = new AppcastItem(theItemElement, theParent);
+  return item;
+}
+
+AppcastItem* AppcastItem::FromScanner(XmlScanner& theScanner, StringPool* theStringPool, QObject* theParent) {
 
-  if (!item->ParseXml()) {
+  AppcastItem* item = new AppcastItem(theStringPool, theParent);
+
+  if (!item->ParseXml(theScanner)) {
     delete item;
     item = nullptr;
   }
@@ -42,10 +52,10 @@ AppcastItem* AppcastItem::FromElement(const QDomElement& theItemElement, QObject
   return item;
 }
 
-AppcastItem* AppcastItem::NewItem(const QString& theVersionDescription, const qlonglong theVersionBuild, QObject* theParent) {
+AppcastItem* AppcastItem::NewItem(const QString& theVersionDescription, const qlonglong theVersionBuild, StringPool* theStringPool, QObject* theParent) {
 
-  AppcastItem* item = new AppcastItem(theParent);
-  item->versionDescription = theVersionDescription;
+  AppcastItem* item = new AppcastItem(theStringPool, theParent);
+  item->versionDescription = item->Intern(theVersionDescription);
   item->versionBuild = theVersionBuild;
   item->publishedTimestamp = QDateTime::currentDateTimeUtc();
   
@@ -61,24 +71,118 @@ AppcastItem::~AppcastItem() {
 
 #pragma mark Private
 
+QString AppcastItem::Intern(const QString& theString) const {
+
+  return (stringPool != nullptr) ? stringPool->Intern(theString) : theString;
+}
+
+void AppcastItem::MaterializeEnclosures() const {
+
+  if (pendingEnclosureXml.IsNull()) {
+    return;
+  }
+
+  XmlScanner xmlScanner(pendingEnclosureXml.Data(), pendingEnclosureXml.Size());
+  pendingEnclosureXml = Utf8View();
+
+  // enclosures share the item's arena (if it has one)
+  MonotonicArena::Scope arenaScope(ArenaOf(this));
+
+  // materialized enclosures are owned by this item just like eagerly parsed ones
+  AppcastItem* owner = const_cast<AppcastItem*>(this);
+
+  XmlTag currTag;
+
+  while (xmlScanner.ReadNextStartTag(currTag)) {
+
+    if (currTag.name == "enclosure") {
+
+      ItemEnclosure* enclosure = ItemEnclosure::FromTag(currTag, stringPool, owner);
+      if (enclosure != nullptr) {
+        enclosures.append(enclosure);
+      }
+
+      xmlScanner.SkipElement(currTag);
+    }
+    else if (currTag.name == "sparkle:deltas" && !currTag.selfClosing) {
+
+      XmlTag deltaTag;
+
+      while (xmlScanner.ReadNextStartTag(deltaTag)) {
+
+        if (deltaTag.name == "enclosure") {
+
+          ItemDelta* delta = ItemDelta::FromTag(deltaTag, stringPool, owner);
+          if (delta != nullptr) {
+            enclosures.append(delta);
+
+            deltaHash[delta->VersionBuild()][delta->Platform()] = delta;
+          }
+        }
+
+        xmlScanner.SkipElement(deltaTag);
+      }
+    }
+    else {
+      xmlScanner.SkipElement(currTag);
+    }
+  }
+}
+
+#pragma mark Public
+
 QDateTime AppcastItem::TimestampFromString(const QString& theString) {
 
-  QDateTime timestamp = QDateTime::fromString(theString, "ddd, dd MMM yyyy HH:mm:ss +0000");
-  timestamp.setTimeSpec(Qt::TimeSpec::UTC);
+  const QByteArray timestampData = theString.toLatin1();
+
+  return TimestampFromUtf8(timestampData.constData(), timestampData.size());
+}
+
+QDateTime AppcastItem::TimestampFromUtf8(const char* theData, const int theSize) {
 
-  return timestamp;
+  // pubDates are parsed by hand - QDateTime::fromString() re-parses the pattern each time and is locale dependent
+  bool isValid = false;
+  const qint64 secsSinceEpoch = Rfc822Date::ParseSecsSinceEpoch(theData, theSize, &isValid);
+
+  if (!isValid) {
+    return QDateTime();
+  }
+
+  return QDateTime::fromMSecsSinceEpoch(secsSinceEpoch * 1000, Qt::UTC);
 }
 
 QString AppcastItem::TimestampToString(const QDateTime& theTimestamp) {
 
-  return theTimestamp.toString("ddd, dd MMM yyyy HH:mm:ss +0000");
+  if (!theTimestamp.isValid()) {
+    return QString();
+  }
+
+  const qint64 msecsSinceEpoch = theTimestamp.toMSecsSinceEpoch();
+  const qint64 secsSinceEpoch = msecsSinceEpoch / 1000 - ((msecsSinceEpoch % 1000 < 0) ? 1 : 0);
+
+  char timestampBuffer[Rfc822Date::FORMATTED_SIZE];
+  const int timestampSize = Rfc822Date::FormatSecsSinceEpoch(secsSinceEpoch, timestampBuffer);
+
+  return QString::fromLatin1(timestampBuffer, timestampSize);
 }
 
-#pragma mark Public
+const QList<ItemEnclosure*>& AppcastItem::Enclosures() const {
+
+  MaterializeEnclosures();
+
+  return enclosures;
+}
+
+const QList<ItemDelta*>& AppcastItem::Deltas() const {
+
+  MaterializeEnclosures();
+
+  return deltas;
+}
 
 ItemEnclosure* AppcastItem::Enclosure(const EnclosurePlatform thePlatform) const {
 
-  foreach (ItemEnclosure* currEnclosure, enclosures) {
+  foreach (ItemEnclosure* currEnclosure, Enclosures()) {
 
     if (currEnclosure != nullptr && currEnclosure->Platform() == thePlatform) {
       return currEnclosure;
@@ -99,7 +203,7 @@ void AppcastItem::Print() const {
   qInfo().noquote().nospace() << QString("%1 %2 (%3)").arg(title).arg(versionDescription).arg(versionBuild);
   qInfo().noquote().nospace() << "  Published: " << publishedTimestamp.toString();
   qInfo().noquote().nospace() << "  Enclosures";
-  foreach (ItemEnclosure* currEnclosure, enclosures) {
+  foreach (ItemEnclosure* currEnclosure, Enclosures()) {
     if (currEnclosure != nullptr) {
 
       qInfo().noquote().nospace() << "     "
@@ -116,49 +220,111 @@ void AppcastItem::Print() const {
 
 #pragma mark Private
 
-bool AppcastItem::ParseXml() {
-
-  title = itemElement.firstChildElement("title").firstChild().nodeValue();
-  description = itemElement.firstChildElement("description").firstChild().nodeValue();
-  releaseNotesUrl = itemElement.firstChildElement("sparkle:releaseNotesLink").firstChild().nodeValue();
+bool AppcastItem::ParseXml(QXmlStreamReader& theReader) {
 
-  const QString publishedTimestampStr = itemElement.firstChildElement("pubDate").firstChild().nodeValue();
-  publishedTimestamp = TimestampFromString(publishedTimestampStr);
+  // expects the reader to be positioned on the <item> start element, consumes up to and including </item>
+  while (theReader.readNextStartElement()) {
 
-  QDomElement enclosureElement = itemElement.firstChildElement("enclosure");
+    const QStringRef elementName = theReader.qualifiedName();
 
-  while (!enclosureElement.isNull()) {
+    if (elementName == QLatin1String("title")) {
+      title = Intern(theReader.readElementText(QXmlStreamReader::IncludeChildElements));
+    }
+    else if (elementName == QLatin1String("description")) {
+      description = theReader.readElementText(QXmlStreamReader::IncludeChildElements);
+    }
+    else if (elementName == QLatin1String("sparkle:releaseNotesLink")) {
+      releaseNotesUrl = theReader.readElementText(QXmlStreamReader::IncludeChildElements);
+    }
+    else if (elementName == QLatin1String("pubDate")) {
+      publishedTimestamp = TimestampFromString(theReader.readElementText(QXmlStreamReader::IncludeChildElements));
+    }
+    else if (elementName == QLatin1String("enclosure")) {
 
-    ItemEnclosure* enclosure = ItemEnclosure::FromElement(enclosureElement, this);
-    if (enclosure != nullptr) {
-      enclosures.append(enclosure);
+      ItemEnclosure* enclosure = ItemEnclosure::FromAttributes(theReader.attributes(), stringPool, this);
+      if (enclosure != nullptr) {
+        enclosures.append(enclosure);
 
-      // assign item version to enclosure version if it is unset
-      if (versionBuild < 0 && enclosure->VersionBuild() >= 0) {
-        versionDescription = enclosure->VersionDescription();
-        versionBuild = enclosure->VersionBuild();
+        // assign item version to enclosure version if it is unset
+        if (versionBuild < 0 && enclosure->VersionBuild() >= 0) {
+          versionDescription = enclosure->VersionDescription();
+          versionBuild = enclosure->VersionBuild();
+        }
       }
+
+      theReader.skipCurrentElement();
     }
+    else if (elementName == QLatin1String("sparkle:deltas")) {
 
-    enclosureElement = enclosureElement.nextSiblingElement("enclosure");
+      while (theReader.readNextStartElement()) {
+
+        if (theReader.qualifiedName() == QLatin1String("enclosure")) {
+
+          ItemDelta* delta = ItemDelta::FromAttributes(theReader.attributes(), stringPool, this);
+          if (delta != nullptr) {
+            enclosures.append(delta);
+
+            deltaHash[delta->VersionBuild()][delta->Platform()] = delta;
+          }
+        }
+
+        theReader.skipCurrentElement();
+      }
+    }
+    else {
+      theReader.skipCurrentElement();
+    }
   }
 
-  QDomElement deltasElement = itemElement.firstChildElement("sparkle:deltas");
-  if (!deltasElement.isNull()) {
+  return !theReader.hasError();
+}
+
+bool AppcastItem::ParseXml(XmlScanner& theScanner) {
 
-    QDomElement deltaEnclosureElement = deltasElement.firstChildElement("enclosure");
+  // expects the scanner to be positioned after the <item> start tag, consumes up to and including </item>
+  const qint64 bodyBegin = theScanner.Position();
+  bool hasEnclosures = false;
 
-    while (!deltaEnclosureElement.isNull()) {
+  XmlTag currTag;
 
-      ItemDelta* delta = ItemDelta::FromElement(deltaEnclosureElement, this);
-      if (delta != nullptr) {
-        enclosures.append(delta);
+  while (theScanner.ReadNextStartTag(currTag)) {
 
-        deltaHash[delta->VersionBuild()][delta->Platform()] = delta;
+    if (currTag.name == "title") {
+      title = Intern(theScanner.ReadElementText(currTag));
+    }
+    else if (currTag.name == "description") {
+      description = theScanner.ReadElementText(currTag);
+    }
+    else if (currTag.name == "sparkle:releaseNotesLink") {
+      releaseNotesUrl = theScanner.ReadElementText(currTag);
+    }
+    else if (currTag.name == "pubDate") {
+      const Utf8View pubDate = theScanner.ReadElementContent(currTag);
+      publishedTimestamp = TimestampFromUtf8(pubDate.Data(), pubDate.Size());
+    }
+    else if (currTag.name == "enclosure" || currTag.name == "sparkle:deltas") {
+
+      // only the item's version is read up front (from its first enclosure, as in the eager parsers)
+      if (versionBuild < 0 && currTag.name == "enclosure") {
+        versionDescription = Intern(currTag.Attribute("sparkle:shortVersionString").ToString());
+        versionBuild = currTag.Attribute("sparkle:version").ToLongLong();
       }
 
-      deltaEnclosureElement = deltaEnclosureElement.nextSiblingElement("enclosure");
+      hasEnclosures = true;
+      theScanner.SkipElement(currTag);
     }
+    else {
+      theScanner.SkipElement(currTag);
+    }
+  }
+
+  if (theScanner.HasError()) {
+    return false;
+  }
+
+  if (hasEnclosures) {
+    const qint64 bodyEnd = (currTag.closing && currTag.name == "item") ? currTag.begin : theScanner.Position();
+    pendingEnclosureXml = Utf8View(theScanner.Data() + bodyBegin, static_cast<int>(bodyEnd - bodyBegin));
   }
 
   return true;
@@ -168,7 +334,7 @@ bool AppcastItem::ParseXml() {
 
 void AppcastItem::SetTitle(const QString& theTitle) {
 
-  title = theTitle;
+  title = Intern(theTitle);
 }
 
 void AppcastItem::SetDescription(const QString& theDescription) {
@@ -183,7 +349,9 @@ void AppcastItem::SetReleaseNotesUrl(const QUrl& theUrl) {
 
 ItemEnclosure* AppcastItem::AddEnclosure(const qlonglong theLength, const QUrl &theUrl, const EnclosurePlatform thePlatform, const QByteArray &theSignature, const EnclosureSignatureType theSignatureType) {
 
-  ItemEnclosure* enclosure = ItemEnclosure::NewEnclosure(theLength, versionBuild, versionDescription, theUrl, thePlatform, theSignature, theSignatureType);
+  MaterializeEnclosures();
+
+  ItemEnclosure* enclosure = ItemEnclosure::NewEnclosure(theLength, versionBuild, versionDescription, theUrl, thePlatform, theSignature, theSignatureType, stringPool);
 
   if (enclosure != nullptr) {
     enclosures.append(enclosure);
@@ -194,7 +362,9 @@ ItemEnclosure* AppcastItem::AddEnclosure(const qlonglong theLength, const QUrl &
 
 ItemDelta* AppcastItem::AddDelta(const qlonglong prevBuildVersion, const qlonglong theLength, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType) {
 
-  ItemDelta* delta = ItemDelta::NewDelta(theLength, prevBuildVersion, versionBuild, versionDescription, theUrl, thePlatform, theSignature, theSignatureType);
+  MaterializeEnclosures();
+
+  ItemDelta* delta = ItemDelta::NewDelta(theLength, prevBuildVersion, versionBuild, versionDescription, theUrl, thePlatform, theSignature, theSignatureType, stringPool);
 
   if (delta != nullptr) {
     deltas.append(delta);
@@ -15,16 +15,22 @@
 #include <QDateTime>
 
 #include "Constants.hpp"
+#include "utils/MonotonicArena.hpp"
+#include "utils/Utf8View.hpp"
+
+class QXmlStreamReader;
+class XmlScanner;
+class StringPool;
 
 class ItemEnclosure;
 class ItemDelta;
 
-class AppcastItem : public QObject {
+class AppcastItem : public QObject, public ArenaAllocated {
   Q_OBJECT
 
 private:
 
-  QDomElement itemElement;
+  StringPool* stringPool = nullptr;
 
   QString title;
   QString description;
@@ -35,10 +41,13 @@ private:
   QString versionDescription;
   qlonglong versionBuild = -1;
 
-  QList<ItemEnclosure*> enclosures;
-  QList<ItemDelta*> deltas;
+  mutable QList<ItemEnclosure*> enclosures;
+  mutable QList<ItemDelta*> deltas;
+
+  mutable QHash<qlonglong, QHash<EnclosurePlatform, ItemDelta*>> deltaHash;
 
-  QHash<qlonglong, QHash<EnclosurePlatform, ItemDelta*>> deltaHash;
+  // unparsed <item> body of items read from a mapped appcast, enclosures are only materialized on first access
+  mutable Utf8View pendingEnclosureXml;
 
 
 #pragma mark - Constructors -
@@ -46,14 +55,14 @@ private:
 #pragma mark Private
 private:
 
-  AppcastItem(QObject* theParent = nullptr);
-  AppcastItem(const QDomElement&, QObject* theParent = nullptr);
+  AppcastItem(StringPool* theStringPool, QObject* theParent = nullptr);
 
 #pragma mark Public
 public:
 
-  static AppcastItem* FromElement(const QDomElement&, QObject* theParent = nullptr);
-  static AppcastItem* NewItem(const QString& theVersionDescription, const qlonglong theVersionBuild, QObject* theParent = nullptr);
+  static AppcastItem* FromReader(QXmlStreamReader&, StringPool* theStringPool = nullptr, QObject* theParent = nullptr);
+  static AppcastItem* FromScanner(XmlScanner&, StringPool* theStringPool = nullptr, QObject* theParent = nullptr);
+  static AppcastItem* NewItem(const QString& theVersionDescription, const qlonglong theVersionBuild, StringPool* theStringPool = nullptr, QObject* theParent = nullptr);
 
   virtual ~AppcastItem() Q_DECL_OVERRIDE;
 
@@ -63,12 +72,17 @@ public:
 #pragma mark Private
 private:
 
-  static QDateTime TimestampFromString(const QString&);
-  static QString TimestampToString(const QDateTime&);
+  QString Intern(const QString&) const;
+
+  void MaterializeEnclosures() const;
 
 #pragma mark Public
 public:
 
+  static QDateTime TimestampFromString(const QString&);
+  static QDateTime TimestampFromUtf8(const char* theData, const int theSize);
+  static QString TimestampToString(const QDateTime&);
+
   const QString Title() const { return title; }
   const QString Description() const { return description; }
 
@@ -80,11 +94,11 @@ public:
   const QString& VersionDescription() const { return versionDescription; }
   qlonglong VersionBuild() const { return versionBuild; }
 
-  const QList<ItemEnclosure*>& Enclosures() const { return enclosures; }
+  const QList<ItemEnclosure*>& Enclosures() const;
   ItemEnclosure* Enclosure(const EnclosurePlatform) const;
   bool HasEnclosure(const EnclosurePlatform) const;
 
-  const QList<ItemDelta*>& Deltas() const { return deltas; }
+  const QList<ItemDelta*>& Deltas() const;
   ItemDelta Delta(const EnclosurePlatform, const qlonglong) const;
 
 
@@ -96,7 +110,8 @@ public:
 #pragma mark Private
 private:
 
-  bool ParseXml();
+  bool ParseXml(QXmlStreamReader&);
+  bool ParseXml(XmlScanner&);
 
 #pragma mark Public
 public:
@@ -0,0 +1,392 @@
+//
+//  AppcastModel.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "AppcastModel.hpp"
+
+#include <QDebug>
+#include <QUrl>
+
+#include <algorithm>
+#include <functional>
+
+#include "AppcastItem.hpp"
+#include "ItemEnclosure.hpp"
+#include "ItemDelta.hpp"
+#include "utils/XmlScanner.hpp"
+
+static AppcastModel::EnclosureRecord EnclosureRecordFromTag(const XmlTag& theEnclosureTag) {
+
+  AppcastModel::EnclosureRecord enclosureRecord;
+  enclosureRecord.build = theEnclosureTag.Attribute("sparkle:version").ToLongLong();
+
+  const Utf8View lengthValue = theEnclosureTag.Attribute("length");
+  enclosureRecord.length = !lengthValue.IsNull() ? lengthValue.ToLongLong() : -1;
+
+  enclosureRecord.platform = ItemEnclosure::PlatformFromXmlValue(theEnclosureTag.Attribute("sparkle:os").ToString());
+
+  // same priority as ItemEnclosure
+  if (theEnclosureTag.HasAttribute("sparkle:edSignature")) {
+    enclosureRecord.signatureType = Ed25519Signature;
+  }
+  else if (theEnclosureTag.HasAttribute("sparkle:dsaSignature")) {
+    enclosureRecord.signatureType = DsaSignature;
+  }
+
+  enclosureRecord.fileUrl = theEnclosureTag.Attribute("url");
+  enclosureRecord.installerArguments = theEnclosureTag.Attribute("sparkle:installerArguments");
+
+  return enclosureRecord;
+}
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+
+AppcastModel::AppcastModel() {
+
+}
+
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+
+quint32 AppcastModel::HashBuild(const qlonglong theBuildVersion) {
+
+  // builds are mostly sequential, so the bits are mixed before masking
+  quint64 hash = static_cast<quint64>(theBuildVersion);
+  hash ^= hash >> 33;
+  hash *= Q_UINT64_C(0xff51afd7ed558ccd);
+  hash ^= hash >> 33;
+
+  return static_cast<quint32>(hash);
+}
+
+QString AppcastModel::ElementText(const Utf8View& theElementXml) {
+
+  if (theElementXml.IsNull()) {
+    return QString();
+  }
+
+  XmlScanner xmlScanner(theElementXml.Data(), theElementXml.Size());
+  XmlTag elementTag;
+
+  if (!xmlScanner.ReadNextStartTag(elementTag)) {
+    return QString();
+  }
+
+  return xmlScanner.ReadElementText(elementTag);
+}
+
+#pragma mark Public
+
+int AppcastModel::IndexOf(const qlonglong theBuildVersion) const {
+
+  if (theBuildVersion < 0 || buildSlots.isEmpty()) {
+    return -1;
+  }
+
+  const int slotMask = buildSlots.count() - 1;
+
+  // the table is never more than 3/4 full, so probing always reaches an empty slot
+  for (int slot = static_cast<int>(HashBuild(theBuildVersion) & slotMask); ; slot = (slot + 1) & slotMask) {
+
+    const int itemIndex = buildSlots.at(slot);
+
+    if (itemIndex < 0) {
+      return -1;
+    }
+    if (itemRecords.at(itemIndex).build == theBuildVersion) {
+      return itemIndex;
+    }
+  }
+}
+
+bool AppcastModel::ContainsEnclosure(const qlonglong theBuildVersion, const EnclosurePlatform thePlatform) const {
+
+  const int itemIndex = IndexOf(theBuildVersion);
+
+  return itemIndex >= 0 && (itemRecords.at(itemIndex).enclosureMask & PlatformBit(thePlatform)) != 0;
+}
+
+void AppcastModel::BuildOrderedBuilds() const {
+
+  for (int platform = NullPlatform; platform <= WindowsPlatform; platform++) {
+    orderedBuilds[platform].clear();
+  }
+
+  const ItemRecord* itemEnd = itemRecords.constData() + itemRecords.count();
+
+  for (const ItemRecord* currItem = itemRecords.constData(); currItem != itemEnd; currItem++) {
+
+    if (currItem->build < 0) {
+      continue;
+    }
+
+    for (int platform = NullPlatform; platform <= WindowsPlatform; platform++) {
+      if ((currItem->platformMask & PlatformBit(static_cast<EnclosurePlatform>(platform))) != 0) {
+        orderedBuilds[platform].append(currItem->build);
+      }
+    }
+  }
+
+  for (int platform = NullPlatform; platform <= WindowsPlatform; platform++) {
+    QVector<qlonglong>& builds = orderedBuilds[platform];
+    std::sort(builds.begin(), builds.end());
+    builds.erase(std::unique(builds.begin(), builds.end()), builds.end());
+  }
+
+  orderedBuildsValid = true;
+}
+
+QVector<qlonglong> AppcastModel::BuildsBefore(const qlonglong theBuildVersion, const EnclosurePlatform thePlatform, const int theMaxCount) const {
+
+  if (thePlatform < NullPlatform || thePlatform > WindowsPlatform) {
+    return QVector<qlonglong>();
+  }
+
+  if (!orderedBuildsValid) {
+    BuildOrderedBuilds();
+  }
+
+  const QVector<qlonglong>& builds = orderedBuilds[thePlatform];
+
+  // everything before the first build >= theBuildVersion is a predecessor
+  const qlonglong* predecessorsEnd = std::lower_bound(builds.constBegin(), builds.constEnd(), theBuildVersion);
+  const int predecessorCount = static_cast<int>(predecessorsEnd - builds.constBegin());
+  const int resultCount = (theMaxCount >= 0) ? qMin(theMaxCount, predecessorCount) : predecessorCount;
+
+  QVector<qlonglong> predecessors;
+  predecessors.reserve(resultCount);
+
+  for (int index = 0; index < resultCount; index++) {
+    predecessors.append(*(predecessorsEnd - 1 - index));
+  }
+
+  return predecessors;
+}
+
+void AppcastModel::PrintItem(const int theItemIndex) const {
+
+  // same output as AppcastItem::Print()
+  const ItemRecord& itemRecord = itemRecords.at(theItemIndex);
+
+  qInfo();
+  qInfo().noquote().nospace() << QString("%1 %2 (%3)").arg(ElementText(itemRecord.titleXml)).arg(itemRecord.versionDescription.ToString()).arg(itemRecord.build);
+  qInfo().noquote().nospace() << "  Published: " << AppcastItem::TimestampFromUtf8(itemRecord.pubDate.Data(), itemRecord.pubDate.Size()).toString();
+  qInfo().noquote().nospace() << "  Enclosures";
+
+  for (const EnclosureRecord* currEnclosure = EnclosuresBegin(theItemIndex); currEnclosure != EnclosuresEnd(theItemIndex); currEnclosure++) {
+
+    const QString installerArguments = currEnclosure->installerArguments.ToString();
+
+    qInfo().noquote().nospace() << "     "
+      << QString("%1:  %2").arg(ItemEnclosure::PlatformToDescription(currEnclosure->platform), 7).arg(QUrl(currEnclosure->fileUrl.ToString()).toString())
+      << QString(" [%1]").arg(ItemEnclosure::SignatureTypeToDescription(currEnclosure->signatureType))
+      << (!installerArguments.isEmpty() ? QString(" (%1)").arg(installerArguments) : "");
+  }
+}
+
+
+#pragma mark - Mutators -
+
+#pragma mark Private
+
+void AppcastModel::IndexBuild(const qlonglong theBuildVersion, const int theItemIndex) {
+
+  if ((indexedCount + 1) * 4 > buildSlots.count() * 3) {
+    Rehash(qMax(16, buildSlots.count() * 2));
+  }
+
+  const int slotMask = buildSlots.count() - 1;
+  int slot = static_cast<int>(HashBuild(theBuildVersion) & slotMask);
+
+  while (buildSlots.at(slot) >= 0) {
+
+    // duplicate builds resolve to the last item in document order
+    if (itemRecords.at(buildSlots.at(slot)).build == theBuildVersion) {
+      buildSlots[slot] = theItemIndex;
+      return;
+    }
+
+    slot = (slot + 1) & slotMask;
+  }
+
+  buildSlots[slot] = theItemIndex;
+  indexedCount++;
+}
+
+void AppcastModel::Rehash(const int theSlotCount) {
+
+  Q_ASSERT((theSlotCount & (theSlotCount - 1)) == 0);
+
+  const QVector<int> prevSlots = buildSlots;
+  buildSlots = QVector<int>(theSlotCount, -1);
+
+  const int slotMask = theSlotCount - 1;
+
+  foreach (const int itemIndex, prevSlots) {
+
+    if (itemIndex < 0) {
+      continue;
+    }
+
+    int slot = static_cast<int>(HashBuild(itemRecords.at(itemIndex).build) & slotMask);
+    while (buildSlots.at(slot) >= 0) {
+      slot = (slot + 1) & slotMask;
+    }
+
+    buildSlots[slot] = itemIndex;
+  }
+}
+
+#pragma mark Public
+
+bool AppcastModel::ParseItem(XmlScanner& theScanner, const XmlTag& theItemTag) {
+
+  ItemRecord itemRecord;
+  itemRecord.offset = theItemTag.begin;
+  itemRecord.firstEnclosure = enclosureRecords.count();
+
+  XmlTag currTag;
+
+  while (!theItemTag.selfClosing && theScanner.ReadNextStartTag(currTag)) {
+
+    if (currTag.name == "title") {
+      theScanner.SkipElement(currTag);
+      itemRecord.titleXml = Utf8View(theScanner.Data() + currTag.begin, static_cast<int>(theScanner.Position() - currTag.begin));
+    }
+    else if (currTag.name == "pubDate") {
+      itemRecord.pubDate = theScanner.ReadElementContent(currTag);
+    }
+    else if (currTag.name == "enclosure") {
+
+      const EnclosureRecord enclosureRecord = EnclosureRecordFromTag(currTag);
+
+      // same rule as AppcastItem - the item's version comes from its first enclosure
+      if (itemRecord.build < 0) {
+        itemRecord.build = enclosureRecord.build;
+        itemRecord.versionDescription = currTag.Attribute("sparkle:shortVersionString");
+      }
+
+      itemRecord.platformMask |= PlatformBit(enclosureRecord.platform);
+      itemRecord.enclosureMask |= PlatformBit(enclosureRecord.platform);
+      enclosureRecords.append(enclosureRecord);
+
+      theScanner.SkipElement(currTag);
+    }
+    else if (currTag.name == "sparkle:deltas" && !currTag.selfClosing) {
+
+      XmlTag deltaTag;
+
+      while (theScanner.ReadNextStartTag(deltaTag)) {
+
+        if (deltaTag.name == "enclosure") {
+
+          EnclosureRecord deltaRecord = EnclosureRecordFromTag(deltaTag);
+          deltaRecord.deltaFrom = deltaTag.Attribute("sparkle:deltaFrom").ToLongLong();
+
+          itemRecord.enclosureMask |= PlatformBit(deltaRecord.platform);
+          enclosureRecords.append(deltaRecord);
+        }
+
+        theScanner.SkipElement(deltaTag);
+      }
+    }
+    else {
+      theScanner.SkipElement(currTag);
+    }
+  }
+
+  if (theScanner.HasError()) {
+    enclosureRecords.resize(itemRecord.firstEnclosure);
+    return false;
+  }
+
+  itemRecord.length = theScanner.Position() - itemRecord.offset;
+  itemRecord.enclosureCount = enclosureRecords.count() - itemRecord.firstEnclosure;
+
+  itemRecords.append(itemRecord);
+  orderedBuildsValid = false;
+
+  if (itemRecord.build >= 0) {
+    IndexBuild(itemRecord.build, itemRecords.count() - 1);
+  }
+
+  return true;
+}
+
+void AppcastModel::AppendItem(const AppcastItem* theItem) {
+
+  Q_ASSERT(theItem != nullptr);
+
+  ItemRecord itemRecord;
+  itemRecord.build = theItem->VersionBuild();
+  itemRecord.firstEnclosure = enclosureRecords.count();
+
+  foreach (ItemEnclosure* currEnclosure, theItem->Enclosures()) {
+
+    if (currEnclosure == nullptr) {
+      continue;
+    }
+
+    EnclosureRecord enclosureRecord;
+    enclosureRecord.build = currEnclosure->VersionBuild();
+    enclosureRecord.length = currEnclosure->Length();
+    enclosureRecord.platform = currEnclosure->Platform();
+    enclosureRecord.signatureType = currEnclosure->SignatureType();
+
+    const ItemDelta* delta = qobject_cast<const ItemDelta*>(currEnclosure);
+    if (delta != nullptr) {
+      enclosureRecord.deltaFrom = delta->InitialVersionBuild();
+    }
+    else {
+      itemRecord.platformMask |= PlatformBit(enclosureRecord.platform);
+    }
+
+    itemRecord.enclosureMask |= PlatformBit(enclosureRecord.platform);
+    enclosureRecords.append(enclosureRecord);
+  }
+
+  itemRecord.enclosureCount = enclosureRecords.count() - itemRecord.firstEnclosure;
+
+  itemRecords.append(itemRecord);
+  orderedBuildsValid = false;
+
+  if (itemRecord.build >= 0) {
+    IndexBuild(itemRecord.build, itemRecords.count() - 1);
+  }
+}
+
+void AppcastModel::Append(const AppcastModel& theModel) {
+
+  const int enclosureOffset = enclosureRecords.count();
+
+  enclosureRecords += theModel.enclosureRecords;
+  itemRecords.reserve(itemRecords.count() + theModel.itemRecords.count());
+  orderedBuildsValid = false;
+
+  foreach (ItemRecord currRecord, theModel.itemRecords) {
+
+    currRecord.firstEnclosure += enclosureOffset;
+    itemRecords.append(currRecord);
+
+    if (currRecord.build >= 0) {
+      IndexBuild(currRecord.build, itemRecords.count() - 1);
+    }
+  }
+}
+
+void AppcastModel::Clear() {
+
+  itemRecords.clear();
+  enclosureRecords.clear();
+  buildSlots.clear();
+  indexedCount = 0;
+  orderedBuildsValid = false;
+}
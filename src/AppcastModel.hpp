@@ -0,0 +1,135 @@
+//
+//  AppcastModel.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef AppcastModel_hpp
+#define AppcastModel_hpp
+
+#include <QObject>
+#include <QVector>
+
+#include "Constants.hpp"
+#include "utils/Utf8View.hpp"
+
+struct XmlTag;
+class XmlScanner;
+class AppcastItem;
+
+// flat, value-type description of an appcast's items. Items and their enclosures (deltas included) are
+// stored as plain records in two contiguous arrays, with builds resolved through an open-addressing table,
+// so feed-wide scans never have to touch the QObject facades (AppcastItem/ItemEnclosure/ItemDelta).
+//
+// Records parsed from a scanner keep views into the scanned buffer, which must outlive the model.
+class AppcastModel {
+
+public:
+
+  struct EnclosureRecord {
+    qlonglong build = -1;
+    qlonglong deltaFrom = -1;     // -1 for full enclosures
+    qlonglong length = -1;
+    EnclosurePlatform platform = NullPlatform;
+    EnclosureSignatureType signatureType = NullSignature;
+    Utf8View fileUrl;
+    Utf8View installerArguments;
+  };
+
+  struct ItemRecord {
+    qlonglong build = -1;
+    qint64 offset = -1;           // byte range of the <item> element, when parsed from a scanner
+    qint64 length = 0;
+    quint8 platformMask = 0;      // platforms with a full (non-delta) enclosure
+    quint8 enclosureMask = 0;     // platforms with any enclosure, deltas included
+    int firstEnclosure = 0;
+    int enclosureCount = 0;
+    Utf8View versionDescription;
+    Utf8View titleXml;            // whole element, text is only decoded when printed
+    Utf8View pubDate;
+  };
+
+private:
+
+  QVector<ItemRecord> itemRecords;
+  QVector<EnclosureRecord> enclosureRecords;
+
+  // open-addressing (linear probing) build -> item record index, -1 marks an empty slot
+  QVector<int> buildSlots;
+  int indexedCount = 0;
+
+  // per platform, ascending unique builds with a full enclosure for the platform. Rebuilt lazily (once) after
+  // the records change, so predecessor queries are a binary search plus the k builds returned
+  mutable QVector<qlonglong> orderedBuilds[WindowsPlatform + 1];
+  mutable bool orderedBuildsValid = false;
+
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+public:
+
+  AppcastModel();
+
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+private:
+
+  static quint32 HashBuild(const qlonglong);
+  static QString ElementText(const Utf8View& theElementXml);
+
+  void BuildOrderedBuilds() const;
+
+#pragma mark Public
+public:
+
+  static quint8 PlatformBit(const EnclosurePlatform thePlatform) { return static_cast<quint8>(1u << thePlatform); }
+
+  int ItemCount() const { return itemRecords.count(); }
+  const ItemRecord& Item(const int theItemIndex) const { return itemRecords.at(theItemIndex); }
+
+  const EnclosureRecord* EnclosuresBegin(const int theItemIndex) const { return enclosureRecords.constData() + itemRecords.at(theItemIndex).firstEnclosure; }
+  const EnclosureRecord* EnclosuresEnd(const int theItemIndex) const { return EnclosuresBegin(theItemIndex) + itemRecords.at(theItemIndex).enclosureCount; }
+
+  int IndexOf(const qlonglong theBuildVersion) const;
+
+  bool Contains(const qlonglong theBuildVersion) const { return IndexOf(theBuildVersion) >= 0; }
+  // true for any enclosure of the platform, deltas included - same as AppcastItem::HasEnclosure()
+  bool ContainsEnclosure(const qlonglong theBuildVersion, const EnclosurePlatform) const;
+
+  // up to theMaxCount (-1 for all) builds older than theBuildVersion with a full enclosure for the platform,
+  // newest first - O(log n + k)
+  QVector<qlonglong> BuildsBefore(const qlonglong theBuildVersion, const EnclosurePlatform, const int theMaxCount = -1) const;
+
+  void PrintItem(const int theItemIndex) const;
+
+
+#pragma mark - Mutators -
+
+#pragma mark Private
+private:
+
+  void IndexBuild(const qlonglong theBuildVersion, const int theItemIndex);
+  void Rehash(const int theSlotCount);
+
+#pragma mark Public
+public:
+
+  // expects the scanner to be positioned after theItemTag, consumes up to and including </item>
+  bool ParseItem(XmlScanner&, const XmlTag& theItemTag);
+
+  // records the numeric fields of an already parsed item (its string fields stay null)
+  void AppendItem(const AppcastItem*);
+
+  // appends every record of theModel (e.g. parsed concurrently from a later part of the same buffer)
+  void Append(const AppcastModel& theModel);
+
+  void Clear();
+
+};
+
+#endif /* AppcastModel_hpp */
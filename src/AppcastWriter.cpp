@@ -0,0 +1,201 @@
+//
+//  AppcastWriter.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "AppcastWriter.hpp"
+
+#include <QDebug>
+#include <QDomDocument>
+#include <QXmlStreamWriter>
+
+#include <algorithm>
+
+#include "AppcastItem.hpp"
+#include "ItemDelta.hpp"
+#include "ItemEnclosure.hpp"
+
+typedef QPair<QString, QString> AttributePair;
+
+static bool AttributeLessThan(const AttributePair& theLeft, const AttributePair& theRight) {
+
+  const bool leftIsNamespace = theLeft.first.startsWith("xmlns");
+  const bool rightIsNamespace = theRight.first.startsWith("xmlns");
+
+  if (leftIsNamespace != rightIsNamespace) {
+    return leftIsNamespace;
+  }
+
+  return theLeft.first < theRight.first;
+}
+
+// both writers emit attributes through here, so an element's attribute order never depends on where it came from
+static void WriteAttributes(QXmlStreamWriter& theWriter, QVector<AttributePair>& theAttributes) {
+
+  std::sort(theAttributes.begin(), theAttributes.end(), AttributeLessThan);
+
+  foreach (const AttributePair& currAttribute, theAttributes) {
+    theWriter.writeAttribute(currAttribute.first, currAttribute.second);
+  }
+}
+
+static void WriteAttributes(QXmlStreamWriter& theWriter, const QXmlStreamAttributes& theAttributes) {
+
+  QVector<AttributePair> attributes;
+  attributes.reserve(theAttributes.count());
+
+  foreach (const QXmlStreamAttribute& currAttribute, theAttributes) {
+    attributes.append(AttributePair(currAttribute.qualifiedName().toString(), currAttribute.value().toString()));
+  }
+
+  WriteAttributes(theWriter, attributes);
+}
+
+static void ConfigureWriter(QXmlStreamWriter& theWriter) {
+
+  theWriter.setAutoFormatting(true);
+  theWriter.setAutoFormattingIndent(0);
+}
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+
+void AppcastWriter::WriteNode(QXmlStreamWriter& theWriter, const QDomNode& theNode) {
+
+  switch (theNode.nodeType()) {
+
+    case QDomNode::ElementNode: {
+
+      const QDomElement element = theNode.toElement();
+      const QDomNamedNodeMap attributeMap = element.attributes();
+
+      QVector<AttributePair> attributes;
+      attributes.reserve(attributeMap.count());
+
+      for (int index = 0; index < attributeMap.count(); index++) {
+        const QDomAttr currAttribute = attributeMap.item(index).toAttr();
+        attributes.append(AttributePair(currAttribute.name(), currAttribute.value()));
+      }
+
+      theWriter.writeStartElement(element.tagName());
+      WriteAttributes(theWriter, attributes);
+
+      for (QDomNode childNode = element.firstChild(); !childNode.isNull(); childNode = childNode.nextSibling()) {
+        WriteNode(theWriter, childNode);
+      }
+
+      theWriter.writeEndElement();
+      break;
+    }
+    case QDomNode::TextNode: {
+      if (!theNode.nodeValue().trimmed().isEmpty()) {
+        theWriter.writeCharacters(theNode.nodeValue());
+      }
+      break;
+    }
+    case QDomNode::CDATASectionNode: {
+      theWriter.writeCDATA(theNode.nodeValue());
+      break;
+    }
+    case QDomNode::CommentNode: {
+      theWriter.writeComment(theNode.nodeValue());
+      break;
+    }
+    case QDomNode::ProcessingInstructionNode: {
+      // the xml declaration is written by writeStartDocument()
+      const QDomProcessingInstruction instruction = theNode.toProcessingInstruction();
+      if (instruction.target() != "xml") {
+        theWriter.writeProcessingInstruction(instruction.target(), instruction.data());
+      }
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+}
+
+#pragma mark Public
+
+QByteArray AppcastWriter::ItemXml(const AppcastItem* theItem) {
+
+  if (theItem == nullptr) {
+    return QByteArray();
+  }
+
+  QByteArray itemXml;
+  QXmlStreamWriter xmlWriter(&itemXml);
+  ConfigureWriter(xmlWriter);
+
+  xmlWriter.writeStartElement("item");
+
+  xmlWriter.writeTextElement("title", theItem->Title());
+  xmlWriter.writeTextElement("pubDate", theItem->PublishedTimestampString());
+
+  if (!theItem->Description().isEmpty()) {
+    xmlWriter.writeTextElement("description", theItem->Description());
+  }
+  if (!theItem->ReleaseNotesUrl().isEmpty()) {
+    xmlWriter.writeTextElement("sparkle:releaseNotesLink", theItem->ReleaseNotesUrl().toString());
+  }
+
+  foreach (ItemEnclosure* currEnclosure, theItem->Enclosures()) {
+
+    if (currEnclosure == nullptr) { qWarning() << "error serializing item - the item has a null enclosure object"; return QByteArray(); }
+
+    QXmlStreamAttributes enclosureAttributes;
+    if (currEnclosure->Serialize(enclosureAttributes)) {
+      xmlWriter.writeEmptyElement("enclosure");
+      WriteAttributes(xmlWriter, enclosureAttributes);
+    }
+  }
+
+  QList<QXmlStreamAttributes> deltaAttributes;
+
+  foreach (ItemDelta* currDelta, theItem->Deltas()) {
+
+    if (currDelta == nullptr) { qWarning() << "error serializing item - the item has a null delta object"; return QByteArray(); }
+
+    QXmlStreamAttributes currAttributes;
+    if (currDelta->Serialize(currAttributes)) {
+      deltaAttributes.append(currAttributes);
+    }
+  }
+
+  if (!deltaAttributes.isEmpty()) {
+
+    xmlWriter.writeStartElement("sparkle:deltas");
+
+    foreach (const QXmlStreamAttributes& currAttributes, deltaAttributes) {
+      xmlWriter.writeEmptyElement("enclosure");
+      WriteAttributes(xmlWriter, currAttributes);
+    }
+
+    xmlWriter.writeEndElement();
+  }
+
+  xmlWriter.writeEndElement();
+
+  return itemXml.trimmed();
+}
+
+QByteArray AppcastWriter::DocumentXml(const QDomDocument& theDocument) {
+
+  QByteArray documentXml;
+  QXmlStreamWriter xmlWriter(&documentXml);
+  ConfigureWriter(xmlWriter);
+
+  xmlWriter.writeStartDocument();
+
+  for (QDomNode childNode = theDocument.firstChild(); !childNode.isNull(); childNode = childNode.nextSibling()) {
+    WriteNode(xmlWriter, childNode);
+  }
+
+  xmlWriter.writeEndDocument();
+
+  return documentXml;
+}
@@ -0,0 +1,45 @@
+//
+//  AppcastWriter.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef AppcastWriter_hpp
+#define AppcastWriter_hpp
+
+#include <QByteArray>
+
+class QDomDocument;
+class QDomNode;
+class QXmlStreamWriter;
+class AppcastItem;
+
+// canonical appcast serialization - unlike QDomDocument::toByteArray() (whose attribute order depends on
+// QHash seeding), writing unchanged content always produces the same bytes, so re-saving a feed doesn't bust
+// cdn/etag caches. Elements are written one per line without indentation, whitespace-only text is dropped.
+class AppcastWriter {
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+private:
+
+  static void WriteNode(QXmlStreamWriter&, const QDomNode&);
+
+#pragma mark Public
+public:
+
+  // a single <item> (no xml declaration) with a fixed element order: title, pubDate, description,
+  // releaseNotesLink, enclosures, deltas. Attributes are sorted the same way as in DocumentXml().
+  // Returns a null byte array if the item can't be serialized
+  static QByteArray ItemXml(const AppcastItem*);
+
+  // the whole document, document order is preserved and every element's attributes are sorted by name
+  // (namespace declarations first)
+  static QByteArray DocumentXml(const QDomDocument&);
+
+};
+
+#endif /* AppcastWriter_hpp */
@@ -10,29 +10,43 @@
 
 #include <QDebug>
 
+#include "utils/XmlScanner.hpp"
+
 #pragma mark - Constructors -
 
 #pragma mark Private
 
-ItemDelta::ItemDelta(const qlonglong theLength, const qlonglong thePrevBuild, const qlonglong theNewBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, QObject* theParent)
-: ItemEnclosure(theLength, theNewBuild, theVersion, theUrl, thePlatform, theSignature, theSignatureType, theParent) {
+ItemDelta::ItemDelta(const qlonglong theLength, const qlonglong thePrevBuild, const qlonglong theNewBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, StringPool* theStringPool, QObject* theParent)
+: ItemEnclosure(theLength, theNewBuild, theVersion, theUrl, thePlatform, theSignature, theSignatureType, theStringPool, theParent) {
 
   initialVersionBuild = thePrevBuild;
 
 }
 
-ItemDelta::ItemDelta(const QDomElement& theEnclosureElement, QObject* theParent)
-: ItemEnclosure(theEnclosureElement, theParent) {
+ItemDelta::ItemDelta(StringPool* theStringPool, QObject* theParent)
+: ItemEnclosure(theStringPool, theParent) {
 
 }
 
 #pragma mark Public
 
-ItemDelta* ItemDelta::FromElement(const QDomElement& theEnclosureElement, QObject* theParent) {
+ItemDelta* ItemDelta::FromAttributes(const QXmlStreamAttributes& theAttributes, StringPool* theStringPool, QObject* theParent) {
+
+  ItemDelta* enclsoure = new ItemDelta(theStringPool, theParent);
+
+  if (!enclsoure->ParseXml(theAttributes)) {
+    delete enclsoure;
+    enclsoure = nullptr;
+  }
+
+  return enclsoure;
+}
+
+ItemDelta* ItemDelta::FromTag(const XmlTag& theEnclosureTag, StringPool* theStringPool, QObject* theParent) {
 
-  ItemDelta* enclsoure = new ItemDelta(theEnclosureElement, theParent);
+  ItemDelta* enclsoure = new ItemDelta(theStringPool, theParent);
 
-  if (!enclsoure->ParseXml()) {
+  if (!enclsoure->ParseXml(theEnclosureTag)) {
     delete enclsoure;
     enclsoure = nullptr;
   }
@@ -40,9 +54,9 @@ ItemDelta* ItemDelta::FromElement(const QDomElement& theEnclosureElement, QObjec
   return enclsoure;
 }
 
-ItemDelta* ItemDelta::NewDelta(const qlonglong theLength, const qlonglong thePrevBuild, const qlonglong theNewBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, QObject* theParent) {
+ItemDelta* ItemDelta::NewDelta(const qlonglong theLength, const qlonglong thePrevBuild, const qlonglong theNewBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, StringPool* theStringPool, QObject* theParent) {
 
-  ItemDelta* delta = new ItemDelta(theLength, thePrevBuild, theNewBuild, theVersion, theUrl, thePlatform, theSignature, theSignatureType, theParent);
+  ItemDelta* delta = new ItemDelta(theLength, thePrevBuild, theNewBuild, theVersion, theUrl, thePlatform, theSignature, theSignatureType, theStringPool, theParent);
 
   return delta;
 }
@@ -71,26 +85,37 @@ void ItemDelta::Print() const {
 
 #pragma mark Private
 
-bool ItemDelta::ParseXml() {
+bool ItemDelta::ParseXml(const QXmlStreamAttributes& theAttributes) {
 
-  if (!ItemEnclosure::ParseXml()) {
+  if (!ItemEnclosure::ParseXml(theAttributes)) {
     return false;
   }
 
-  initialVersionBuild = EnclosureElement().attribute("sparkle:deltaFrom").toLongLong();
+  initialVersionBuild = theAttributes.value("sparkle:deltaFrom").toLongLong();
   
   return true;
 }
 
+bool ItemDelta::ParseXml(const XmlTag& theEnclosureTag) {
+
+  if (!ItemEnclosure::ParseXml(theEnclosureTag)) {
+    return false;
+  }
+
+  initialVersionBuild = theEnclosureTag.Attribute("sparkle:deltaFrom").ToLongLong();
+
+  return true;
+}
+
 #pragma mark Public
 
-bool ItemDelta::Serialize(QDomElement& theDeltaElement) {
+bool ItemDelta::Serialize(QXmlStreamAttributes& theAttributes) const {
 
-  if (!ItemEnclosure::Serialize(theDeltaElement)) {
+  if (!ItemEnclosure::Serialize(theAttributes)) {
     return false;
   }
 
-  theDeltaElement.setAttribute("sparkle:deltaFrom", QString::number(initialVersionBuild));
+  theAttributes.append("sparkle:deltaFrom", QString::number(initialVersionBuild));
 
   return true;
 }
@@ -24,16 +24,16 @@ private:
 #pragma mark Protected
 protected:
 
-  ItemDelta(QObject* theParent = nullptr);
-  ItemDelta(const qlonglong theLength, const qlonglong thePrevBuild, const qlonglong theNewBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, QObject* theParent = nullptr);
-  ItemDelta(const QDomElement&, QObject* theParent = nullptr);
+  ItemDelta(StringPool* theStringPool, QObject* theParent = nullptr);
+  ItemDelta(const qlonglong theLength, const qlonglong thePrevBuild, const qlonglong theNewBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, StringPool* theStringPool = nullptr, QObject* theParent = nullptr);
 
 #pragma mark Public
 public:
 
-  static ItemDelta* FromElement(const QDomElement&, QObject* theParent = nullptr);
+  static ItemDelta* FromAttributes(const QXmlStreamAttributes&, StringPool* theStringPool = nullptr, QObject* theParent = nullptr);
+  static ItemDelta* FromTag(const XmlTag&, StringPool* theStringPool = nullptr, QObject* theParent = nullptr);
 
-  static ItemDelta* NewDelta(const qlonglong theLength, const qlonglong thePrevBuild, const qlonglong theNewBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, QObject* theParent = nullptr);
+  static ItemDelta* NewDelta(const qlonglong theLength, const qlonglong thePrevBuild, const qlonglong theNewBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, StringPool* theStringPool = nullptr, QObject* theParent = nullptr);
 
   virtual ~ItemDelta() Q_DECL_OVERRIDE;
 
@@ -56,12 +56,13 @@ public:
 #pragma mark Protected
 protected:
 
-  virtual bool ParseXml() Q_DECL_OVERRIDE;
+  virtual bool ParseXml(const QXmlStreamAttributes&) Q_DECL_OVERRIDE;
+  virtual bool ParseXml(const XmlTag&) Q_DECL_OVERRIDE;
 
 #pragma mark Public
 public:
 
-  virtual bool Serialize(QDomElement& theDeltaElement) Q_DECL_OVERRIDE;
+  virtual bool Serialize(QXmlStreamAttributes& theAttributes) const Q_DECL_OVERRIDE;
 
 
 };
@@ -10,6 +10,9 @@
 
 #include <QDebug>
 
+#include "utils/StringPool.hpp"
+#include "utils/XmlScanner.hpp"
+
 QList<EnclosureSignatureType> ItemEnclosure::VALID_SIGNATURE_TYPES = {
   Ed25519Signature,
   DsaSignature,
@@ -19,19 +22,19 @@ QList<EnclosureSignatureType> ItemEnclosure::VALID_SIGNATURE_TYPES = {
 
 #pragma mark Protected
 
-ItemEnclosure::ItemEnclosure(QObject* theParent)
-: QObject(theParent) {
+ItemEnclosure::ItemEnclosure(StringPool* theStringPool, QObject* theParent)
+: QObject(theParent), stringPool(theStringPool) {
   
 }
 
-ItemEnclosure::ItemEnclosure(const qlonglong theLength, const qlonglong theBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, QObject* theParent)
-: QObject(theParent) {
+ItemEnclosure::ItemEnclosure(const qlonglong theLength, const qlonglong theBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, StringPool* theStringPool, QObject* theParent)
+: QObject(theParent), stringPool(theStringPool) {
 
   length = theLength;
   versionBuild = theBuild;
-  versionDescription = theVersion;
+  versionDescription = Intern(theVersion);
   fileUrl = theUrl;
-  mimeType = "application/octet-stream";
+  mimeType = Intern("application/octet-stream");
 
   platform = thePlatform;
 
@@ -39,28 +42,30 @@ ItemEnclosure::ItemEnclosure(const qlonglong theLength, const qlonglong theBuild
   signatureType = theSignatureType;
 
   if (thePlatform == WindowsPlatform) {
-    // InnoSetup
-    installerArguments = QStringList{ "/SILENT", "/SP-" };
-    // MSI
-    installerArguments = QStringList{ "/SILENT", "/passive" };
-    // NSIS
-    installerArguments = QStringList{ "/SILENT", "/S" };
+    // NSIS (InnoSetup uses "/SILENT /SP-", MSI "/SILENT /passive")
+    installerArguments = InternList("/SILENT /S");
   }
 }
 
-ItemEnclosure::ItemEnclosure(const QDomElement& theEnclosureElement, QObject* theParent)
-: QObject(theParent) {
+#pragma mark Public
 
-  enclosureElement = theEnclosureElement;
-}
+ItemEnclosure* ItemEnclosure::FromAttributes(const QXmlStreamAttributes& theAttributes, StringPool* theStringPool, QObject* theParent) {
 
-#pragma mark Public
+  ItemEnclosure* enclsoure = new ItemEnclosure(theStringPool, theParent);
 
-ItemEnclosure* ItemEnclosure::FromElement(const QDomElement& theEnclosureElement, QObject* theParent) {
+  if (!enclsoure->ParseXml(theAttributes)) {
+    delete enclsoure;
+    enclsoure = nullptr;
+  }
 
-  ItemEnclosure* enclsoure = new ItemEnclosure(theEnclosureElement, theParent);
+  return enclsoure;
+}
 
-  if (!enclsoure->ParseXml()) {
+ItemEnclosure* ItemEnclosure::FromTag(const XmlTag& theEnclosureTag, StringPool* theStringPool, QObject* theParent) {
+
+  ItemEnclosure* enclsoure = new ItemEnclosure(theStringPool, theParent);
+
+  if (!enclsoure->ParseXml(theEnclosureTag)) {
     delete enclsoure;
     enclsoure = nullptr;
   }
@@ -68,9 +73,9 @@ ItemEnclosure* ItemEnclosure::FromElement(const QDomElement& theEnclosureElement
   return enclsoure;
 }
 
-ItemEnclosure* ItemEnclosure::NewEnclosure(const qlonglong theLength, const qlonglong theBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, QObject* theParent) {
+ItemEnclosure* ItemEnclosure::NewEnclosure(const qlonglong theLength, const qlonglong theBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, StringPool* theStringPool, QObject* theParent) {
 
-  ItemEnclosure* enclosure = new ItemEnclosure(theLength, theBuild, theVersion, theUrl, thePlatform, theSignature, theSignatureType, theParent);
+  ItemEnclosure* enclosure = new ItemEnclosure(theLength, theBuild, theVersion, theUrl, thePlatform, theSignature, theSignatureType, theStringPool, theParent);
 
   return enclosure;
 }
@@ -84,8 +89,67 @@ ItemEnclosure::~ItemEnclosure() {
 
 #pragma mark Private
 
+QString ItemEnclosure::Intern(const QString& theString) const {
+
+  return (stringPool != nullptr) ? stringPool->Intern(theString) : theString;
+}
+
+QStringList ItemEnclosure::InternList(const QString& theJoinedList) const {
+
+  if (stringPool != nullptr) {
+    return stringPool->InternList(theJoinedList);
+  }
+
+  return theJoinedList.isEmpty() ? QStringList() : theJoinedList.split(' ');
+}
+
 #pragma mark Public
 
+const QString& ItemEnclosure::VersionDescription() const {
+
+  if (versionDescription.isNull() && !rawVersionDescription.IsNull()) {
+    versionDescription = Intern(rawVersionDescription.ToString());
+  }
+
+  return versionDescription;
+}
+
+const QUrl& ItemEnclosure::FileUrl() const {
+
+  if (fileUrl.isEmpty() && !rawFileUrl.IsEmpty()) {
+    fileUrl = QUrl(rawFileUrl.ToString());
+  }
+
+  return fileUrl;
+}
+
+const QString& ItemEnclosure::MimeType() const {
+
+  if (mimeType.isNull() && !rawMimeType.IsNull()) {
+    mimeType = Intern(rawMimeType.ToString());
+  }
+
+  return mimeType;
+}
+
+const QByteArray& ItemEnclosure::Signature() const {
+
+  if (signature.isNull() && !rawSignature.IsNull()) {
+    signature = rawSignature.ToByteArray();
+  }
+
+  return signature;
+}
+
+const QStringList& ItemEnclosure::InstallerArguments() const {
+
+  if (installerArguments.isEmpty() && !rawInstallerArguments.IsEmpty()) {
+    installerArguments = InternList(rawInstallerArguments.ToString());
+  }
+
+  return installerArguments;
+}
+
 EnclosureSignatureType ItemEnclosure::SignatureTypeFromXmlKey(const QString& theString) {
 
   EnclosureSignatureType signatureType = NullSignature;
@@ -176,8 +240,8 @@ QString ItemEnclosure::PlatformToDescription(const EnclosurePlatform& thePlatfor
 
 void ItemEnclosure::Print() const {
 
-  qInfo() << QString("File Url: %1").arg(fileUrl.toString(), 20);
-  qInfo().noquote().nospace() << fileUrl.path().section('/', -1);
+  qInfo() << QString("File Url: %1").arg(FileUrl().toString(), 20);
+  qInfo().noquote().nospace() << FileUrl().path().section('/', -1);
 }
 
 
@@ -186,81 +250,112 @@ void ItemEnclosure::Print() const {
 
 #pragma mark Private
 
-bool ItemEnclosure::ParseXml() {
+bool ItemEnclosure::ParseXml(const QXmlStreamAttributes& theAttributes) {
 
-  versionDescription = enclosureElement.attribute("sparkle:shortVersionString");
-  versionBuild = enclosureElement.attribute("sparkle:version").toLongLong();
+  versionDescription = Intern(theAttributes.value("sparkle:shortVersionString").toString());
+  versionBuild = theAttributes.value("sparkle:version").toLongLong();
 
-  fileUrl = QUrl(enclosureElement.attribute("url"));
-  mimeType = enclosureElement.attribute("type");
-  length = enclosureElement.hasAttribute("length") ? enclosureElement.attribute("length").toLongLong() : -1;
+  fileUrl = QUrl(theAttributes.value("url").toString());
+  mimeType = Intern(theAttributes.value("type").toString());
+  length = theAttributes.hasAttribute("length") ? theAttributes.value("length").toLongLong() : -1;
 
   // iterate through possible signature types (by priority) and assign the first available
   foreach (const EnclosureSignatureType currSignatureType, VALID_SIGNATURE_TYPES) {
 
     const QString currSignatureTypeKey = SignatureTypeToXmlKey(currSignatureType);
 
-    if (enclosureElement.hasAttribute(currSignatureTypeKey)) {
-      signature = enclosureElement.attribute(currSignatureTypeKey).toUtf8();
+    if (theAttributes.hasAttribute(currSignatureTypeKey)) {
+      signature = theAttributes.value(currSignatureTypeKey).toUtf8();
       signatureType = currSignatureType;
       break;
     }
   }
   
   if (signatureType == NullSignature) {
-    qWarning() << "ItemEnclosure::ParseXml() warning - enclosure is missing signature: " << enclosureElement.toDocument().toString();
+    qWarning() << "ItemEnclosure::ParseXml() warning - enclosure is missing signature: " << fileUrl.toString();
   }
 
-  platform = PlatformFromXmlValue(enclosureElement.attribute("sparkle:os"));
+  platform = PlatformFromXmlValue(theAttributes.value("sparkle:os").toString());
   
-  if (enclosureElement.hasAttribute("sparkle:installerArguments")) {
+  if (theAttributes.hasAttribute("sparkle:installerArguments")) {
 
-    const QString installerArgumentsStr = enclosureElement.attribute("sparkle:installerArguments");
+    const QString installerArgumentsStr = theAttributes.value("sparkle:installerArguments").toString();
 
     if (!installerArgumentsStr.isEmpty()) {
-      installerArguments = installerArgumentsStr.split(' ');
+      installerArguments = InternList(installerArgumentsStr);
+    }
+  }
+
+  return true;
+}
+
+bool ItemEnclosure::ParseXml(const XmlTag& theEnclosureTag) {
+
+  // string attributes are kept as views into the scanned buffer until an accessor needs them
+  rawVersionDescription = theEnclosureTag.Attribute("sparkle:shortVersionString");
+  versionBuild = theEnclosureTag.Attribute("sparkle:version").ToLongLong();
+
+  rawFileUrl = theEnclosureTag.Attribute("url");
+  rawMimeType = theEnclosureTag.Attribute("type");
+
+  const Utf8View lengthValue = theEnclosureTag.Attribute("length");
+  length = !lengthValue.IsNull() ? lengthValue.ToLongLong() : -1;
+
+  // iterate through possible signature types (by priority) and assign the first available
+  foreach (const EnclosureSignatureType currSignatureType, VALID_SIGNATURE_TYPES) {
+
+    const Utf8View signatureValue = theEnclosureTag.Attribute(SignatureTypeToXmlKey(currSignatureType).toLatin1().constData());
+
+    if (!signatureValue.IsNull()) {
+      rawSignature = signatureValue;
+      signatureType = currSignatureType;
+      break;
     }
   }
 
+  if (signatureType == NullSignature) {
+    qWarning() << "ItemEnclosure::ParseXml() warning - enclosure is missing signature: " << FileUrl().toString();
+  }
+
+  platform = PlatformFromXmlValue(theEnclosureTag.Attribute("sparkle:os").ToString());
+
+  rawInstallerArguments = theEnclosureTag.Attribute("sparkle:installerArguments");
+
   return true;
 }
 
 #pragma mark Public
 
-bool ItemEnclosure::Serialize(QDomElement& theEnclosureElement) {
+bool ItemEnclosure::Serialize(QXmlStreamAttributes& theAttributes) const {
 
   if (versionBuild < 0) { qWarning().noquote().nospace() << "error serializing enclosure - invalid version: " << versionBuild; return false; }
   if (platform == NullPlatform) { qWarning().noquote().nospace() << "error serializing enclosure - platform is null"; return false; }
-  if (!fileUrl.isValid()) { qWarning().noquote().nospace() << "error serializing enclosure - invalid url: " << fileUrl.toString(); return false; }
+  if (!FileUrl().isValid()) { qWarning().noquote().nospace() << "error serializing enclosure - invalid url: " << FileUrl().toString(); return false; }
   if (length <= 0) { qWarning().noquote().nospace() << "error serializing enclosure - invalid length: " << length; return false; }
   if (signatureType == NullSignature) { qWarning().noquote().nospace() << "error serializing enclosure - signature type is null"; return false; }
-  if (signature.isEmpty()) { qWarning().noquote().nospace() << "error serializing enclosure - empty signature"; return false; }
+  if (Signature().isEmpty()) { qWarning().noquote().nospace() << "error serializing enclosure - empty signature"; return false; }
 
-  theEnclosureElement.setAttribute("sparkle:version", QString::number(versionBuild));
-  if (!versionDescription.isEmpty()) {
-    theEnclosureElement.setAttribute("sparkle:shortVersionString", versionDescription);
+  theAttributes.append("sparkle:version", QString::number(versionBuild));
+  if (!VersionDescription().isEmpty()) {
+    theAttributes.append("sparkle:shortVersionString", VersionDescription());
   }
-  theEnclosureElement.setAttribute("sparkle:os", PlatformXmlValue());
+  theAttributes.append("sparkle:os", PlatformXmlValue());
 
-  theEnclosureElement.setAttribute("url", fileUrl.toString());
-  theEnclosureElement.setAttribute("length", QString::number(length));
-  theEnclosureElement.setAttribute(SignatureTypeXmlKey(), QString::fromUtf8(signature));
-  theEnclosureElement.setAttribute("type", mimeType);
+  theAttributes.append("url", FileUrl().toString());
+  theAttributes.append("length", QString::number(length));
+  theAttributes.append(SignatureTypeXmlKey(), QString::fromUtf8(Signature()));
+  theAttributes.append("type", MimeType());
 
-  if (!installerArguments.isEmpty()) {
-    theEnclosureElement.setAttribute("sparkle:installerArguments", installerArguments.join(' '));
-  }
+  QString installerArgumentsValue = InstallerArguments().join(' ');
 
   if (platform == WindowsPlatform) {
 
-    // InnoSetup
-    theEnclosureElement.setAttribute("sparkle:installerArguments", "/SILENT /SP-");
-
-    // MSI
-    //theEnclosureElement.setAttribute("sparkle:installerArguments", "/passive");
+    // InnoSetup (MSI uses "/passive", NSIS "/S")
+    installerArgumentsValue = "/SILENT /SP-";
+  }
 
-    // NSIS
-    //theEnclosureElement.setAttribute("sparkle:installerArguments", "/S");
+  if (!installerArgumentsValue.isEmpty()) {
+    theAttributes.append("sparkle:installerArguments", installerArgumentsValue);
   }
 
   return true;
@@ -13,30 +13,43 @@
 #include <QDomDocument>
 #include <QUrl>
 #include <QDateTime>
+#include <QXmlStreamAttributes>
 
 #include "Constants.hpp"
+#include "utils/MonotonicArena.hpp"
+#include "utils/Utf8View.hpp"
 
-class ItemEnclosure : public QObject {
+struct XmlTag;
+class StringPool;
+
+class ItemEnclosure : public QObject, public ArenaAllocated {
   Q_OBJECT
 
 private:
 
   static QList<EnclosureSignatureType> VALID_SIGNATURE_TYPES;
 
-  QDomElement enclosureElement;
+  StringPool* stringPool = nullptr;
 
-  QString versionDescription;
+  mutable QString versionDescription;
   qlonglong versionBuild = -1;
 
-  QUrl fileUrl;
-  QString mimeType;
+  mutable QUrl fileUrl;
+  mutable QString mimeType;
   qlonglong length = -1;
 
-  QByteArray signature;
+  mutable QByteArray signature;
   EnclosureSignatureType signatureType = NullSignature;
 
   EnclosurePlatform platform = NullPlatform;
-  QStringList installerArguments;
+  mutable QStringList installerArguments;
+
+  // undecoded attribute values for enclosures parsed from a mapped appcast, decoded on first access
+  Utf8View rawVersionDescription;
+  Utf8View rawFileUrl;
+  Utf8View rawMimeType;
+  Utf8View rawSignature;
+  Utf8View rawInstallerArguments;
 
 
 #pragma mark - Constructors -
@@ -44,16 +57,16 @@ private:
 #pragma mark Protected
 protected:
 
-  ItemEnclosure(QObject* theParent = nullptr);
-  ItemEnclosure(const qlonglong theLength, const qlonglong theBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, QObject* theParent = nullptr);
-  ItemEnclosure(const QDomElement&, QObject* theParent = nullptr);
+  ItemEnclosure(StringPool* theStringPool, QObject* theParent = nullptr);
+  ItemEnclosure(const qlonglong theLength, const qlonglong theBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, StringPool* theStringPool = nullptr, QObject* theParent = nullptr);
 
 #pragma mark Public
 public:
 
-  static ItemEnclosure* FromElement(const QDomElement&, QObject* theParent = nullptr);
+  static ItemEnclosure* FromAttributes(const QXmlStreamAttributes&, StringPool* theStringPool = nullptr, QObject* theParent = nullptr);
+  static ItemEnclosure* FromTag(const XmlTag&, StringPool* theStringPool = nullptr, QObject* theParent = nullptr);
 
-  static ItemEnclosure* NewEnclosure(const qlonglong theLength, const qlonglong theBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, QObject* theParent = nullptr);
+  static ItemEnclosure* NewEnclosure(const qlonglong theLength, const qlonglong theBuild, const QString& theVersion, const QUrl& theUrl, const EnclosurePlatform thePlatform, const QByteArray& theSignature, const EnclosureSignatureType theSignatureType, StringPool* theStringPool = nullptr, QObject* theParent = nullptr);
 
   virtual ~ItemEnclosure() Q_DECL_OVERRIDE;
 
@@ -63,22 +76,20 @@ public:
 #pragma mark Private
 private:
 
-#pragma mark Protected
-protected:
-
-  const QDomElement& EnclosureElement() const { return enclosureElement; }
+  QString Intern(const QString&) const;
+  QStringList InternList(const QString&) const;
 
 #pragma mark Public
 public:
 
-  const QString& VersionDescription() const { return versionDescription; }
+  const QString& VersionDescription() const;
   qlonglong VersionBuild() const { return versionBuild; }
 
-  const QUrl& FileUrl() const { return fileUrl; }
-  const QString& MimeType() const { return mimeType; }
+  const QUrl& FileUrl() const;
+  const QString& MimeType() const;
   qlonglong Length() const { return length; }
 
-  const QByteArray& Signature() const { return signature; }
+  const QByteArray& Signature() const;
   EnclosureSignatureType SignatureType() const { return signatureType; }
   QString SignatureTypeXmlKey() const { return SignatureTypeToXmlKey(signatureType); }
   QString SignatureTypeDescription() const { return SignatureTypeToDescription(signatureType); }
@@ -86,7 +97,7 @@ public:
   EnclosurePlatform Platform() const { return platform; }
   QString PlatformXmlValue() const { return PlatformToXmlValue(platform); }
   QString PlatformDescription() const { return PlatformToDescription(platform); }
-  const QStringList& InstallerArguments() const { return installerArguments; }
+  const QStringList& InstallerArguments() const;
 
   static EnclosureSignatureType SignatureTypeFromXmlKey(const QString&);
   static QString SignatureTypeToXmlKey(const EnclosureSignatureType);
@@ -104,12 +115,14 @@ public:
 #pragma mark Protected
 protected:
 
-  virtual bool ParseXml();
+  virtual bool ParseXml(const QXmlStreamAttributes&);
+  virtual bool ParseXml(const XmlTag&);
 
 #pragma mark Public
 public:
 
-  virtual bool Serialize(QDomElement& theEnclosureElement);
+  // appends the enclosure's attributes, AppcastWriter sorts them by name when writing
+  virtual bool Serialize(QXmlStreamAttributes& theAttributes) const;
   
 };
 
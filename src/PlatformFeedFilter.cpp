@@ -0,0 +1,196 @@
+//
+//  PlatformFeedFilter.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "PlatformFeedFilter.hpp"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QPair>
+
+#include "ItemEnclosure.hpp"
+#include "utils/XmlScanner.hpp"
+
+typedef QPair<qint64, qint64> ByteRange;
+
+static inline bool IsSpace(const char theChar) {
+
+  return theChar == ' ' || theChar == '\t' || theChar == '\n' || theChar == '\r';
+}
+
+static bool EnclosureMatchesPlatform(const XmlTag& theEnclosureTag, const EnclosurePlatform thePlatform) {
+
+  const EnclosurePlatform enclosurePlatform = ItemEnclosure::PlatformFromXmlValue(theEnclosureTag.Attribute("sparkle:os").ToString());
+
+  return enclosurePlatform == NullPlatform || enclosurePlatform == thePlatform;
+}
+
+// collects the byte ranges to leave out of each platform's copy of the item, in document order. Expects the
+// scanner to be positioned after theItemTag, consumes up to and including </item>
+static bool CutsForItem(XmlScanner& theScanner, const XmlTag& theItemTag, const QVector<EnclosurePlatform>& thePlatforms, QVector<QVector<ByteRange> >& theCuts) {
+
+  const int platformCount = thePlatforms.count();
+  QVector<bool> hasEnclosure(platformCount, false);
+
+  XmlTag childTag;
+
+  while (theScanner.ReadNextStartTag(childTag)) {
+
+    if (childTag.name == "enclosure") {
+
+      theScanner.SkipElement(childTag);
+
+      for (int platformIndex = 0; platformIndex < platformCount; platformIndex++) {
+        if (EnclosureMatchesPlatform(childTag, thePlatforms.at(platformIndex))) {
+          hasEnclosure[platformIndex] = true;
+        }
+        else {
+          theCuts[platformIndex].append(ByteRange(childTag.begin, theScanner.Position()));
+        }
+      }
+    }
+    else if (childTag.name == "sparkle:deltas" && !childTag.selfClosing) {
+
+      QVector<QVector<ByteRange> > deltaCuts(platformCount);
+      QVector<bool> hasDelta(platformCount, false);
+
+      XmlTag deltaTag;
+
+      while (theScanner.ReadNextStartTag(deltaTag)) {
+
+        theScanner.SkipElement(deltaTag);
+
+        if (deltaTag.name != "enclosure") {
+          continue;
+        }
+
+        for (int platformIndex = 0; platformIndex < platformCount; platformIndex++) {
+          if (EnclosureMatchesPlatform(deltaTag, thePlatforms.at(platformIndex))) {
+            hasDelta[platformIndex] = true;
+          }
+          else {
+            deltaCuts[platformIndex].append(ByteRange(deltaTag.begin, theScanner.Position()));
+          }
+        }
+      }
+
+      // a <sparkle:deltas> without any delta for the platform is left out as a whole
+      for (int platformIndex = 0; platformIndex < platformCount; platformIndex++) {
+        if (hasDelta.at(platformIndex)) {
+          theCuts[platformIndex] += deltaCuts.at(platformIndex);
+        }
+        else {
+          theCuts[platformIndex].append(ByteRange(childTag.begin, theScanner.Position()));
+        }
+      }
+    }
+    else {
+      theScanner.SkipElement(childTag);
+    }
+  }
+
+  if (theScanner.HasError()) {
+    return false;
+  }
+
+  for (int platformIndex = 0; platformIndex < platformCount; platformIndex++) {
+    if (!hasEnclosure.at(platformIndex)) {
+      theCuts[platformIndex].clear();
+      theCuts[platformIndex].append(ByteRange(theItemTag.begin, theScanner.Position()));
+    }
+  }
+
+  return true;
+}
+
+// copies everything up to theCut, minus the whitespace leading up to it, and moves theCopiedOffset past the cut
+static void CopyUpToCut(QByteArray& theOutput, const char* theData, qint64& theCopiedOffset, const ByteRange& theCut) {
+
+  qint64 cutBegin = theCut.first;
+  while (cutBegin > theCopiedOffset && IsSpace(theData[cutBegin - 1])) {
+    cutBegin--;
+  }
+
+  theOutput.append(theData + theCopiedOffset, static_cast<int>(cutBegin - theCopiedOffset));
+  theCopiedOffset = theCut.second;
+}
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+
+QString PlatformFeedFilter::FeedPathForPlatform(const QString& theAppcastPath, const EnclosurePlatform thePlatform) {
+
+  const QFileInfo appcastInfo(theAppcastPath);
+
+  return QString("%1/%2-%3.xml").arg(appcastInfo.absolutePath(), appcastInfo.completeBaseName(), ItemEnclosure::PlatformToXmlValue(thePlatform));
+}
+
+QVector<QByteArray> PlatformFeedFilter::Filter(const QByteArray& theXml, const QVector<EnclosurePlatform>& thePlatforms) {
+
+  const int platformCount = thePlatforms.count();
+  const char* xmlData = theXml.constData();
+
+  QVector<QByteArray> platformFeeds(platformCount);
+  QVector<qint64> copiedOffsets(platformCount, 0);
+
+  for (int platformIndex = 0; platformIndex < platformCount; platformIndex++) {
+    platformFeeds[platformIndex].reserve(theXml.size());
+  }
+
+  XmlScanner xmlScanner(xmlData, theXml.size());
+  XmlTag rssTag;
+
+  if (!xmlScanner.ReadNextStartTag(rssTag) || rssTag.name != "rss") {
+    qWarning().noquote().nospace() << "error filtering appcast xml - missing <rss> element";
+    return QVector<QByteArray>();
+  }
+
+  XmlTag channelTag;
+
+  while (xmlScanner.ReadNextStartTag(channelTag)) {
+
+    if (channelTag.name != "channel" || channelTag.selfClosing) {
+      xmlScanner.SkipElement(channelTag);
+      continue;
+    }
+
+    XmlTag currTag;
+
+    while (xmlScanner.ReadNextStartTag(currTag)) {
+
+      if (currTag.name != "item" || currTag.selfClosing) {
+        xmlScanner.SkipElement(currTag);
+        continue;
+      }
+
+      QVector<QVector<ByteRange> > itemCuts(platformCount);
+
+      if (!CutsForItem(xmlScanner, currTag, thePlatforms, itemCuts)) {
+        break;
+      }
+
+      for (int platformIndex = 0; platformIndex < platformCount; platformIndex++) {
+        foreach (const ByteRange& currCut, itemCuts.at(platformIndex)) {
+          CopyUpToCut(platformFeeds[platformIndex], xmlData, copiedOffsets[platformIndex], currCut);
+        }
+      }
+    }
+  }
+
+  if (xmlScanner.HasError()) {
+    qWarning().noquote().nospace() << "error filtering appcast xml - " << xmlScanner.ErrorString();
+    return QVector<QByteArray>();
+  }
+
+  for (int platformIndex = 0; platformIndex < platformCount; platformIndex++) {
+    const qint64 copiedOffset = copiedOffsets.at(platformIndex);
+    platformFeeds[platformIndex].append(xmlData + copiedOffset, static_cast<int>(theXml.size() - copiedOffset));
+  }
+
+  return platformFeeds;
+}
@@ -0,0 +1,37 @@
+//
+//  PlatformFeedFilter.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef PlatformFeedFilter_hpp
+#define PlatformFeedFilter_hpp
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "Constants.hpp"
+
+// derives per-platform appcasts (appcast-macos.xml, appcast-windows.xml) from serialized appcast xml, so that
+// clients only download enclosures they can install. Enclosures (deltas included) for other platforms are cut
+// out and items left without an enclosure for the platform are dropped; everything else is copied verbatim.
+// Enclosures without a sparkle:os attribute are kept in every feed.
+class PlatformFeedFilter {
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+public:
+
+  static QString FeedPathForPlatform(const QString& theAppcastPath, const EnclosurePlatform);
+
+  // filters theXml for every platform in a single scan, the result holds one feed per platform (in the same
+  // order) - or is empty if theXml couldn't be parsed
+  static QVector<QByteArray> Filter(const QByteArray& theXml, const QVector<EnclosurePlatform>& thePlatforms);
+
+};
+
+#endif /* PlatformFeedFilter_hpp */
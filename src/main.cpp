@@ -12,12 +12,17 @@
 #include "Appcast.hpp"
 #include "AppcastItem.hpp"
 #include "ItemEnclosure.hpp"
+#include "utils/DeltaCache.hpp"
 #include "utils/DeltaGenerator.hpp"
+#include "utils/DeltaScheduler.hpp"
+#include "utils/DeltaSession.hpp"
 #include "utils/DmgMounter.hpp"
 #include "utils/DsaSignatureGenerator.hpp"
 #include "utils/EdDsaSignatureGenerator.hpp"
+#include "utils/SignatureCache.hpp"
 
 #include <QCommandLineParser>
+#include <QDateTime>
 #include <QFile>
 #include <QDomDocument>
 #include <QDebug>
@@ -34,7 +39,7 @@ int main(int argc, char *argv[]) {
   QCommandLineParser parser;
   parser.setApplicationDescription("Appcast generator for Sparkle");
 
-  parser.addPositionalArgument("command", "the command to run", "add|print|sign|delta|help");
+  parser.addPositionalArgument("command", "the command to run", "add|print|archive|sign|delta|help");
   parser.addHelpOption();
 
   /* ---- options used in multiple commands ---- */
@@ -51,16 +56,38 @@ int main(int argc, char *argv[]) {
 
   QCommandLineOption deltasOption("deltas", "The number of delta updates to generate, without specifying this deltas will NOT be generated", "num_deltas");
 
+  QCommandLineOption deltaJobsOption("delta-jobs", "The maximum number of deltas generated at once [default: the number of cores]", "num_jobs");
+  QCommandLineOption deltaCacheDirOption("delta-cache-dir", QString("The dir deltas (and their signatures) are cached in across runs [default: %1]").arg(DeltaCache::DefaultCacheDir()), "dir");
+  QCommandLineOption deltaCacheSizeOption("delta-cache-size", "The size (in MiB) the delta cache is trimmed to, least recently used first. 0 disables the cache [default: 2048]", "mebibytes");
+  QCommandLineOption deltaMemoryOption("delta-memory", "The memory budget (in MiB) shared by deltas generated at once [default: half of the physical memory]", "mebibytes");
+
   QCommandLineOption edDsaKeyOption("eddsa-key", "The Ed25519 key used for signing (the key is passed in-line, not by filepath) [required for macOS delta updates]", "key");
   QCommandLineOption dsaKeyFilePathOption("dsa-key-path", "The local file path to the dsa key used for signing [required for windows bundles]", "key_path");
 
+  QCommandLineOption signatureCacheDirOption("signature-cache-dir", QString("The private dir signatures of unchanged bundles are cached in across runs [default: %1]").arg(SignatureCache::DefaultCacheDir()), "dir");
+  QCommandLineOption noSignatureCacheOption("no-signature-cache", "Always sign bundles (and deltas) from scratch, without reading or writing the signature cache");
+
   QCommandLineOption s3RegionOption("s3-region", "The s3 region (used for url generation)", "region");
   QCommandLineOption s3BucketOption("s3-bucket", "The s3 bucket (used for url generation)", "bucket_name");
   QCommandLineOption s3BucketDirOption("s3-bucket-dir", "The diectory inside the s3 bucket (used for url generation)", "bucket_dir");
   QCommandLineOption s3MirrorPathOption("s3-mirror-path", "The file path to the local mirror of the s3 bucket dir [required for automatic delta generation, requires other s3 options to be set]", "num_deltas");
 
+  QCommandLineOption indexOption("index", "Also write a binary index sidecar (<appcast_path>.idx) used for fast build lookups");
+
+  QCommandLineOption platformFeedsOption("platform-feeds", "Also write per-platform appcasts (<appcast>-macos.xml, <appcast>-windows.xml) that only contain that platform's enclosures");
+
+  QCommandLineOption compressOption("compress", "Also write gzip (.gz) and zstd (.zst) compressed copies of every written appcast");
+  QCommandLineOption compressionLevelOption("compression-level", "The compression level used with '--compress' (gzip: 1-9, zstd: 1-19, clamped per format) [default: each format's maximum]", "level");
+
+  QCommandLineOption manifestOption("manifest", "Also write <appcast_path>.manifest.json with the size, sha-256 and etag of every written file");
+
   QCommandLineOption urlPrefixOption("url-prefix", "The url (without the filename) to be used for the appcast URL generation. This is an alternative ", "url_without_filename");
 
+  /* ---- archive ---- */
+
+  QCommandLineOption keepCountOption("keep", "The number of newest builds kept in the appcast, older items are moved to archive files", "num_items");
+  QCommandLineOption keepSinceOption("keep-since", "Items published on or after this date (yyyy-mm-dd) are kept in the appcast, older items are moved to archive files", "date");
+
   /* ---- delta ---- */
 
   QCommandLineOption previousBundleOption("prev-bundle", "The local file path to the previous app/dmg/zip [required for delta command]", "bundle_path");
@@ -73,22 +100,40 @@ int main(int argc, char *argv[]) {
       appcastOption,
       versionStringOption, versionBuildOption,
       macBundleOption, windowsBundleOption,
-      deltasOption,
+      deltasOption, deltaJobsOption, deltaMemoryOption, deltaCacheDirOption, deltaCacheSizeOption,
       edDsaKeyOption, dsaKeyFilePathOption,
+      signatureCacheDirOption, noSignatureCacheOption,
       s3RegionOption, s3BucketOption, s3BucketDirOption, s3MirrorPathOption,
       urlPrefixOption,
+      indexOption, platformFeedsOption,
+      compressOption, compressionLevelOption,
+      manifestOption,
     });
 
   }
   // print optinos
   else if (qApp->arguments().contains("print")) {
-    parser.addOption(appcastOption);
+    parser.addOptions({
+      appcastOption,
+      versionBuildOption,
+    });
+  }
+  // archive options
+  else if (qApp->arguments().contains("archive")) {
+    parser.addOptions({
+      appcastOption,
+      keepCountOption, keepSinceOption,
+      indexOption, platformFeedsOption,
+      compressOption, compressionLevelOption,
+      manifestOption,
+    });
   }
   // sign options
   else if (qApp->arguments().contains("sign")) {
     parser.addOptions({
       macBundleOption, windowsBundleOption,
       edDsaKeyOption, dsaKeyFilePathOption,
+      signatureCacheDirOption, noSignatureCacheOption,
     });
   }
   // delta options
@@ -120,7 +165,31 @@ int main(int argc, char *argv[]) {
     }
 
     const QString appcastPath = parser.value(appcastOption);
-    Appcast* appcast = Appcast::FromPath(appcastPath);
+
+    // a single build is looked up through the index sidecar when a valid one exists
+    if (parser.isSet(versionBuildOption)) {
+
+      const qlonglong versionBuild = parser.value(versionBuildOption).toLongLong();
+
+      Appcast* appcast = Appcast::FromIndexedPath(appcastPath);
+      if (appcast == nullptr) {
+        appcast = Appcast::FromMappedPath(appcastPath);
+      }
+      if (appcast == nullptr) {
+        return 1;
+      }
+
+      AppcastItem* item = appcast->Item(versionBuild);
+      if (item == nullptr) {
+        qCritical().noquote().nospace() << "No item found for build " << versionBuild << ".";
+        return 1;
+      }
+
+      item->Print();
+      return 0;
+    }
+
+    Appcast* appcast = Appcast::FromMappedPath(appcastPath);
     if (appcast == nullptr) {
       return 1;
     }
@@ -129,9 +198,73 @@ int main(int argc, char *argv[]) {
     return 0;
   }
 
+  /* ---- Archive ---- */
+  else if (command == "archive") {
+
+    if (!parser.isSet(appcastOption)) {
+      qCritical().noquote().nospace() << "`archive` requires '--"<<appcastOption.names().first()<<"'.";
+      return 1;
+    }
+    if (!parser.isSet(keepCountOption) && !parser.isSet(keepSinceOption)) {
+      qCritical().noquote().nospace() << "`archive` requires '--"<<keepCountOption.names().first()<<"' and/or '--"<<keepSinceOption.names().first()<<"'.";
+      return 1;
+    }
+
+    int keepCount = -1;
+    if (parser.isSet(keepCountOption)) {
+      keepCount = parser.value(keepCountOption).toInt();
+      if (QString::number(keepCount) != parser.value(keepCountOption) || keepCount < 1) {
+        qCritical().nospace().noquote() << "invalid value for option '--"<<keepCountOption.names().first()<<"'. Please specify a number > 0'";
+        return 1;
+      }
+    }
+
+    QDateTime keepSince;
+    if (parser.isSet(keepSinceOption)) {
+      const QDate keepSinceDate = QDate::fromString(parser.value(keepSinceOption), Qt::ISODate);
+      if (!keepSinceDate.isValid()) {
+        qCritical().nospace().noquote() << "invalid value for option '--"<<keepSinceOption.names().first()<<"'. Please specify a date as yyyy-mm-dd'";
+        return 1;
+      }
+      keepSince = QDateTime(keepSinceDate, QTime(0, 0), Qt::UTC);
+    }
+
+    int compressionLevel = -1;
+    if (parser.isSet(compressionLevelOption)) {
+      compressionLevel = parser.value(compressionLevelOption).toInt();
+      if (QString::number(compressionLevel) != parser.value(compressionLevelOption) || compressionLevel < 1) {
+        qCritical().nospace().noquote() << "invalid value for option '--"<<compressionLevelOption.names().first()<<"'. Please specify a number > 0'";
+        return 1;
+      }
+    }
+
+    const QString appcastPath = parser.value(appcastOption);
+    Appcast* appcast = Appcast::FromMappedPath(appcastPath);
+    if (appcast == nullptr) {
+      return 1;
+    }
+
+    appcast->SetWritesIndex(parser.isSet(indexOption));
+    appcast->SetWritesPlatformFeeds(parser.isSet(platformFeedsOption));
+    appcast->SetWritesCompressedFeeds(parser.isSet(compressOption));
+    appcast->SetCompressionLevel(compressionLevel);
+    appcast->SetWritesManifest(parser.isSet(manifestOption));
+
+    if (!appcast->Archive(keepCount, keepSince)) { qWarning().noquote().nospace() << "failed to archive appcast items"; return 1; }
+
+    return 0;
+  }
+
   /* ---- Sign ---- */
   else if (command == "sign") {
 
+    if (parser.isSet(noSignatureCacheOption)) {
+      SignatureCache::SetCacheDir(QString());
+    }
+    else if (parser.isSet(signatureCacheDirOption)) {
+      SignatureCache::SetCacheDir(parser.value(signatureCacheDirOption));
+    }
+
     bool hasMacBundle = parser.isSet(macBundleOption);
     bool hasWindowsBundle = parser.isSet(windowsBundleOption);
     bool hasEdDsaKey = parser.isSet(edDsaKeyOption);
@@ -220,6 +353,13 @@ int main(int argc, char *argv[]) {
   /* ---- Add ---- */
   else if (command == "add") {
 
+    if (parser.isSet(noSignatureCacheOption)) {
+      SignatureCache::SetCacheDir(QString());
+    }
+    else if (parser.isSet(signatureCacheDirOption)) {
+      SignatureCache::SetCacheDir(parser.value(signatureCacheDirOption));
+    }
+
 //    parser.addPositionalArgument("command", "The command to run");
 
 //    parser.process(a);
@@ -278,6 +418,22 @@ int main(int argc, char *argv[]) {
       qCritical().nospace().noquote() << "invalid value for option '--"<<deltasOption.names().first()<<"'. Please specify a number > 0'";
       return 1;
     }
+    const int deltaJobsCount = parser.isSet(deltaJobsOption) ? parser.value(deltaJobsOption).toInt() : 0;
+    if (parser.isSet(deltaJobsOption) && (QString::number(deltaJobsCount) != parser.value(deltaJobsOption) || deltaJobsCount < 1)) {
+      qCritical().nospace().noquote() << "invalid value for option '--"<<deltaJobsOption.names().first()<<"'. Please specify a number > 0'";
+      return 1;
+    }
+    const qlonglong deltaMemoryBudget = parser.isSet(deltaMemoryOption) ? parser.value(deltaMemoryOption).toLongLong() : 0;
+    if (parser.isSet(deltaMemoryOption) && (QString::number(deltaMemoryBudget) != parser.value(deltaMemoryOption) || deltaMemoryBudget < 1)) {
+      qCritical().nospace().noquote() << "invalid value for option '--"<<deltaMemoryOption.names().first()<<"'. Please specify a number > 0'";
+      return 1;
+    }
+    const qlonglong deltaCacheSize = parser.isSet(deltaCacheSizeOption) ? parser.value(deltaCacheSizeOption).toLongLong() : DeltaCache::DEFAULT_SIZE_BUDGET / (1024 * 1024);
+    if (parser.isSet(deltaCacheSizeOption) && (QString::number(deltaCacheSize) != parser.value(deltaCacheSizeOption) || deltaCacheSize < 0)) {
+      qCritical().nospace().noquote() << "invalid value for option '--"<<deltaCacheSizeOption.names().first()<<"'. Please specify a number >= 0'";
+      return 1;
+    }
+    const QString deltaCacheDir = parser.isSet(deltaCacheDirOption) ? parser.value(deltaCacheDirOption) : DeltaCache::DefaultCacheDir();
     const QString versionString = parser.value(versionStringOption);
     const qlonglong versionBuild = parser.value(versionBuildOption).toLongLong();
 
@@ -287,12 +443,32 @@ int main(int argc, char *argv[]) {
     const QByteArray edDsaKey = hasEdDsaKey ? parser.value(edDsaKeyOption).toUtf8() : QByteArray();
     const QString dsaKeyPath = hasDsaKeyPath ? parser.value(dsaKeyFilePathOption) : QString();
 
+    int compressionLevel = -1;
+    if (parser.isSet(compressionLevelOption)) {
+      compressionLevel = parser.value(compressionLevelOption).toInt();
+      if (QString::number(compressionLevel) != parser.value(compressionLevelOption) || compressionLevel < 1) {
+        qCritical().nospace().noquote() << "invalid value for option '--"<<compressionLevelOption.names().first()<<"'. Please specify a number > 0'";
+        return 1;
+      }
+    }
+
     const QString appcastPath = parser.value(appcastOption);
-    Appcast* appcast = Appcast::FromPath(appcastPath);
+
+    // build and enclosure lookups are answered from the index sidecar when a valid one exists
+    Appcast* appcast = Appcast::FromIndexedPath(appcastPath);
+    if (appcast == nullptr) {
+      appcast = Appcast::FromMappedPath(appcastPath);
+    }
     if (appcast == nullptr) {
       return 1;
     }
 
+    appcast->SetWritesIndex(parser.isSet(indexOption));
+    appcast->SetWritesPlatformFeeds(parser.isSet(platformFeedsOption));
+    appcast->SetWritesCompressedFeeds(parser.isSet(compressOption));
+    appcast->SetCompressionLevel(compressionLevel);
+    appcast->SetWritesManifest(parser.isSet(manifestOption));
+
     if (parser.isSet(urlPrefixOption)) {
       appcast->SetUrlPrefix(parser.value(urlPrefixOption));
     }
@@ -319,16 +495,41 @@ int main(int argc, char *argv[]) {
 
           qInfo().noquote().nospace() << "\nGenerating deltas for build " << versionBuild << "...\n";
 
+          // the new release is mounted once for every delta, and unmounted when the session goes out of scope
+          DeltaSession deltaSession(macBundlePath, versionBuild, appcast->Title() + ".app");
+
+          // deltas already made by an earlier run (e.g. one that failed later on) are reused without mounting anything
+          DeltaCache deltaCache(deltaCacheDir, deltaCacheSize * 1024 * 1024);
+
+          DeltaScheduler deltaScheduler(&deltaSession, edDsaKey);
+          if (deltaCacheSize > 0) {
+            deltaScheduler.SetCache(&deltaCache);
+          }
+          if (deltaJobsCount > 0) {
+            deltaScheduler.SetMaxJobCount(deltaJobsCount);
+          }
+          if (deltaMemoryBudget > 0) {
+            deltaScheduler.SetMemoryBudget(deltaMemoryBudget * 1024 * 1024);
+          }
+
           int deltasCreated = 0;
-          qlonglong currBuildNumber = newItem->VersionBuild() - 1;
+          qlonglong searchBuildNumber = newItem->VersionBuild();
 
-          while (deltasCreated < deltasCount && currBuildNumber > 0) {
+          // only builds that actually have a mac enclosure are tried, newest first. Candidates are fetched (and
+          // generated concurrently) in batches of the deltas still missing, so builds whose delta fails are
+          // replaced by the next older ones
+          while (deltasCreated < deltasCount && searchBuildNumber > 0) {
 
-            ItemDelta* newDelta = appcast->CreateDeltaForBuild(currBuildNumber, macBundlePath, newItem, MacPlatform, edDsaKey);
-            if (newDelta != nullptr) {
-              deltasCreated++;
+            QVector<qlonglong> candidateBuilds = appcast->PreviousBuilds(searchBuildNumber, MacPlatform, deltasCount - deltasCreated);
+            while (!candidateBuilds.isEmpty() && candidateBuilds.last() <= 0) {
+              candidateBuilds.removeLast();
             }
-            currBuildNumber--;
+            if (candidateBuilds.isEmpty()) {
+              break;
+            }
+
+            deltasCreated += appcast->CreateDeltasForBuilds(candidateBuilds, deltaScheduler, newItem, MacPlatform).count();
+            searchBuildNumber = candidateBuilds.last();
           }
         }
       }
@@ -366,6 +567,7 @@ int main(int argc, char *argv[]) {
     printf("  sign        Generates a signature for a bundle\n");
     printf("  delta       Generates deltas for a bundle\n");
     printf("  print       Print the contents of an existing appcast file\n");
+    printf("  archive     Move old items out of an appcast file into per-year archive files\n");
     printf("  help        Print usage\n");
     printf("\n");
 
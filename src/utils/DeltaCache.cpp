@@ -0,0 +1,256 @@
+//
+//  DeltaCache.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "utils/DeltaCache.hpp"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+#include <utime.h>
+
+#include "utils/DeltaGenerator.hpp"
+#include "utils/FileDigests.hpp"
+
+static const qint64 COPY_CHUNK_SIZE = 1024 * 1024;
+
+static const char* const DELTA_SUFFIX = ".delta";
+static const char* const SIGNATURE_SUFFIX = ".sig";
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+
+DeltaCache::DeltaCache(const QString& theCacheDir, const qint64 theSizeBudget)
+: cacheDir(theCacheDir), sizeBudget(qMax(Q_INT64_C(0), theSizeBudget)) {
+
+}
+
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+
+QString DeltaCache::EntryPath(const QByteArray& theEntryKey, const QString& theSuffix) const {
+
+  return QString("%1/%2%3").arg(cacheDir, QString::fromLatin1(theEntryKey), theSuffix);
+}
+
+#pragma mark Public
+
+QString DeltaCache::DefaultCacheDir() {
+
+  return QString("%1/sparkless/deltas").arg(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation));
+}
+
+QByteArray DeltaCache::ContentHash(const QString& theFilePath) {
+
+  const QString filePath = QFileInfo(theFilePath).absoluteFilePath();
+
+  QFuture<QByteArray> hashFuture;
+
+  {
+    // only the first caller for a path starts hashing it, the future is waited on outside of the lock so jobs
+    // hashing different releases don't wait on each other
+    QMutexLocker cacheLocker(&mutex);
+
+    if (contentHashes.contains(filePath)) {
+      hashFuture = contentHashes.value(filePath);
+    }
+    else {
+      hashFuture = QtConcurrent::run(HashFile, filePath);
+      contentHashes.insert(filePath, hashFuture);
+    }
+  }
+
+  const QByteArray hexHash = hashFuture.result();
+
+  // failures are retried by the next caller
+  if (hexHash.isEmpty()) {
+    QMutexLocker cacheLocker(&mutex);
+    if (contentHashes.value(filePath) == hashFuture) {
+      contentHashes.remove(filePath);
+    }
+  }
+
+  return hexHash;
+}
+
+QByteArray DeltaCache::EntryKey(const QString& theOldReleasePath, const QString& theNewReleasePath, const QByteArray& theEdDsaKey) {
+
+  const QByteArray engineFingerprint = DeltaGenerator::EngineFingerprint();
+  if (engineFingerprint.isEmpty()) {
+    return QByteArray();
+  }
+
+  const QByteArray oldReleaseHash = ContentHash(theOldReleasePath);
+  const QByteArray newReleaseHash = ContentHash(theNewReleasePath);
+  if (oldReleaseHash.isEmpty() || newReleaseHash.isEmpty()) {
+    return QByteArray();
+  }
+
+  // cached signatures are only valid for the key that made them
+  const QByteArray keyFingerprint = QCryptographicHash::hash(theEdDsaKey, QCryptographicHash::Sha256).toHex();
+
+  QCryptographicHash entryHash(QCryptographicHash::Sha256);
+  entryHash.addData(oldReleaseHash + '\n');
+  entryHash.addData(newReleaseHash + '\n');
+  entryHash.addData(engineFingerprint + '\n');
+  entryHash.addData(keyFingerprint);
+
+  return entryHash.result().toHex();
+}
+
+
+#pragma mark - Mutators -
+
+#pragma mark Private
+
+bool DeltaCache::CopyFile(const QString& theSourcePath, const QString& theDestinationPath) {
+
+  QFile sourceFile(theSourcePath);
+  if (!sourceFile.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  // only renamed into place once fully written, so readers never see a partial file
+  QSaveFile destinationFile(theDestinationPath);
+  if (!destinationFile.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+
+  while (!sourceFile.atEnd()) {
+
+    const QByteArray chunk = sourceFile.read(COPY_CHUNK_SIZE);
+    if (chunk.isEmpty() || destinationFile.write(chunk) != chunk.size()) {
+      destinationFile.cancelWriting();
+      return false;
+    }
+  }
+
+  return destinationFile.commit();
+}
+
+QByteArray DeltaCache::HashFile(const QString& theFilePath) {
+
+  const FileDigests fileDigests(theFilePath, FileDigests::Sha256Digest);
+  if (!fileDigests.Success()) {
+    qWarning().noquote().nospace() << "error hashing release for the delta cache: " << theFilePath;
+    return QByteArray();
+  }
+
+  return fileDigests.Sha256().toHex();
+}
+
+void DeltaCache::Evict() {
+
+  QMutexLocker cacheLocker(&mutex);
+
+  // newest (most recently used) first, an entry's use time is its delta's modification time
+  const QFileInfoList deltaInfos = QDir(cacheDir).entryInfoList(QStringList() << QString("*%1").arg(DELTA_SUFFIX), QDir::Files, QDir::Time);
+
+  qint64 totalSize = 0;
+
+  foreach (const QFileInfo& currDeltaInfo, deltaInfos) {
+
+    totalSize += currDeltaInfo.size();
+    if (totalSize <= sizeBudget) {
+      continue;
+    }
+
+    // the signature goes first - an entry without one is never fetched
+    const QByteArray entryKey = currDeltaInfo.completeBaseName().toLatin1();
+    QFile::remove(EntryPath(entryKey, SIGNATURE_SUFFIX));
+    QFile::remove(EntryPath(entryKey, DELTA_SUFFIX));
+  }
+}
+
+#pragma mark Public
+
+bool DeltaCache::Fetch(const QByteArray& theEntryKey, const QString& theDeltaPath, QByteArray& theSignature) {
+
+  if (theEntryKey.isEmpty()) {
+    return false;
+  }
+
+  const QString deltaEntryPath = EntryPath(theEntryKey, DELTA_SUFFIX);
+
+  QFile signatureFile(EntryPath(theEntryKey, SIGNATURE_SUFFIX));
+  if (!signatureFile.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  // <signature>\n<delta size>\n - the size catches a delta that was truncated or replaced behind our back
+  const QList<QByteArray> signatureLines = signatureFile.readAll().split('\n');
+  if (signatureLines.count() < 2 || signatureLines.at(0).isEmpty()) {
+    return false;
+  }
+
+  bool sizeOk = false;
+  const qint64 deltaSize = signatureLines.at(1).toLongLong(&sizeOk);
+  if (!sizeOk || QFileInfo(deltaEntryPath).size() != deltaSize) {
+    return false;
+  }
+
+  QDir().mkpath(QFileInfo(theDeltaPath).absolutePath());
+
+  if (!CopyFile(deltaEntryPath, theDeltaPath)) {
+    qWarning().noquote().nospace() << "error fetching delta from the cache - failed to copy to: " << theDeltaPath;
+    return false;
+  }
+
+  // marks the entry as most recently used
+  utime(QFile::encodeName(deltaEntryPath).constData(), nullptr);
+
+  theSignature = signatureLines.at(0);
+
+  return true;
+}
+
+bool DeltaCache::Store(const QByteArray& theEntryKey, const QString& theDeltaPath, const QByteArray& theSignature) {
+
+  if (theEntryKey.isEmpty() || sizeBudget == 0) {
+    return false;
+  }
+
+  const qint64 deltaSize = QFileInfo(theDeltaPath).size();
+  if (deltaSize > sizeBudget) {
+    return false;
+  }
+
+  if (!QDir().mkpath(cacheDir)) {
+    qWarning().noquote().nospace() << "error storing delta in the cache - failed to create dir: " << cacheDir;
+    return false;
+  }
+
+  if (!CopyFile(theDeltaPath, EntryPath(theEntryKey, DELTA_SUFFIX))) {
+    qWarning().noquote().nospace() << "error storing delta in the cache - failed to copy: " << theDeltaPath;
+    return false;
+  }
+
+  // written last, an entry only becomes visible to Fetch() once its delta is complete
+  QSaveFile signatureFile(EntryPath(theEntryKey, SIGNATURE_SUFFIX));
+  if (!signatureFile.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+
+  signatureFile.write(theSignature + '\n' + QByteArray::number(deltaSize) + '\n');
+  if (!signatureFile.commit()) {
+    qWarning().noquote().nospace() << "error storing delta in the cache - failed to write signature for: " << theDeltaPath;
+    return false;
+  }
+
+  Evict();
+
+  return true;
+}
@@ -0,0 +1,94 @@
+//
+//  DeltaCache.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef DeltaCache_hpp
+#define DeltaCache_hpp
+
+#include <QObject>
+#include <QFuture>
+#include <QHash>
+#include <QMutex>
+
+// persistent, content-addressed store of finished deltas and their EdDSA signatures. Entries are keyed by the
+// sha256 of both releases, the delta engine's fingerprint and the signing key's fingerprint, so a re-run (or
+// another channel needing the same old -> new pair) reuses the delta without mounting or diffing anything.
+// Entries are written atomically and evicted least recently used first once the cache outgrows its budget.
+class DeltaCache {
+
+public:
+
+  static const qint64 DEFAULT_SIZE_BUDGET = Q_INT64_C(2048) * 1024 * 1024;
+
+private:
+
+  QString cacheDir;
+  qint64 sizeBudget = DEFAULT_SIZE_BUDGET;
+
+  // guards contentHashes and eviction, entries may be fetched/stored from several threads (see DeltaScheduler)
+  QMutex mutex;
+  // one hash per path - concurrent jobs sharing a release (e.g. the new one) wait on the same future
+  QHash<QString, QFuture<QByteArray> > contentHashes;
+
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+public:
+
+  explicit DeltaCache(const QString& theCacheDir = DefaultCacheDir(), const qint64 theSizeBudget = DEFAULT_SIZE_BUDGET);
+
+private:
+
+  Q_DISABLE_COPY(DeltaCache)
+
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+private:
+
+  QString EntryPath(const QByteArray& theEntryKey, const QString& theSuffix) const;
+
+#pragma mark Public
+public:
+
+  // <user cache dir>/sparkless/deltas
+  static QString DefaultCacheDir();
+
+  const QString& CacheDir() const { return cacheDir; }
+  qint64 SizeBudget() const { return sizeBudget; }
+
+  // hex sha256 of the file's contents, memoized per path for the lifetime of the cache. Each file is only hashed
+  // once, callers asking for a path that is still being hashed wait for it. Empty on failure (not memoized)
+  QByteArray ContentHash(const QString& theFilePath);
+
+  // empty if either release can't be hashed or the delta engine can't be fingerprinted
+  QByteArray EntryKey(const QString& theOldReleasePath, const QString& theNewReleasePath, const QByteArray& theEdDsaKey);
+
+
+#pragma mark - Mutators -
+
+#pragma mark Private
+private:
+
+  static bool CopyFile(const QString& theSourcePath, const QString& theDestinationPath);
+  static QByteArray HashFile(const QString& theFilePath);
+
+  void Evict();
+
+#pragma mark Public
+public:
+
+  // copies a cached delta to theDeltaPath (replacing anything there) and marks the entry as recently used
+  bool Fetch(const QByteArray& theEntryKey, const QString& theDeltaPath, QByteArray& theSignature);
+
+  bool Store(const QByteArray& theEntryKey, const QString& theDeltaPath, const QByteArray& theSignature);
+
+};
+
+#endif /* DeltaCache_hpp */
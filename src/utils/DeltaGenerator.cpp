@@ -10,10 +10,26 @@
 #include "Constants.hpp"
 
 #include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QFile>
 #include <QFileInfo>
 #include <QDebug>
 #include <QProcess>
 
+static QByteArray ComputeEngineFingerprint(const QString& theProgramPath) {
+
+  QFile programFile(theProgramPath);
+  if (!programFile.open(QIODevice::ReadOnly)) {
+    return QByteArray();
+  }
+
+  QCryptographicHash engineHash(QCryptographicHash::Sha256);
+  engineHash.addData("BinaryDelta create\n");
+  engineHash.addData(&programFile);
+
+  return engineHash.result().toHex();
+}
+
 #pragma mark - Constructors -
 
 #pragma mark Public
@@ -34,6 +50,17 @@ QString DeltaGenerator::GenerateDeltaProgramPath() {
   return QString("%1/%2").arg(HelperScriptsDir(), "BinaryDelta");
 }
 
+#pragma mark Public
+
+QByteArray DeltaGenerator::EngineFingerprint() {
+
+  // function-local statics are initialized once, even with concurrent callers
+  static const QByteArray engineFingerprint = ComputeEngineFingerprint(GenerateDeltaProgramPath());
+
+  return engineFingerprint;
+}
+
+
 #pragma mark - Mutators -
 
 #pragma mark Private
@@ -41,6 +41,10 @@ private:
 #pragma mark Public
 public:
 
+  // identifies the deltas this generator produces (the BinaryDelta binary and its options), so that cached
+  // deltas are never reused across engine changes. Computed once, empty if BinaryDelta can't be read
+  static QByteArray EngineFingerprint();
+
   const QString& OldAppPath() const { return oldAppPath; }
   const QString& NewAppPath() const { return oldAppPath; }
 
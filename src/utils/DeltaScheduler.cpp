@@ -0,0 +1,192 @@
+//
+//  DeltaScheduler.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "utils/DeltaScheduler.hpp"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <unistd.h>
+
+#include "utils/DeltaCache.hpp"
+#include "utils/DeltaSession.hpp"
+#include "utils/EdDsaSignatureGenerator.hpp"
+
+// bsdiff (used by BinaryDelta) needs roughly 9x the old file plus the new file in memory. The dmg sizes stand
+// in for the largest file pair of the bundles
+static const qint64 OLD_RELEASE_MEMORY_FACTOR = 9;
+
+// shared between Run() and its jobs - every finished job records its result and index, then releases the semaphore once
+struct SchedulerState {
+  QMutex mutex;
+  QVector<DeltaScheduler::Result> results;
+  QList<int> finishedJobs;
+  QSemaphore finishedSemaphore;
+};
+
+static DeltaScheduler::Result CreateSignedDelta(const DeltaScheduler* theScheduler, const DeltaScheduler::Job& theJob) {
+
+  DeltaSession* session = theScheduler->Session();
+  DeltaCache* cache = theScheduler->Cache();
+
+  DeltaScheduler::Result result;
+  result.oldBuildNumber = theJob.oldBuildNumber;
+
+  QByteArray cacheKey;
+
+  if (cache != nullptr) {
+
+    cacheKey = cache->EntryKey(theJob.oldReleasePath, session->NewReleasePath(), theScheduler->EdDsaKey());
+
+    const QString deltaPath = session->DeltaPathForBuild(theJob.oldBuildNumber);
+    if (cache->Fetch(cacheKey, deltaPath, result.signature)) {
+      qInfo().noquote().nospace() << "Using cached delta for build " << theJob.oldBuildNumber << " -> " << session->NewBuildNumber();
+      result.deltaPath = deltaPath;
+      result.success = true;
+      return result;
+    }
+  }
+
+  result.deltaPath = session->CreateDelta(theJob.oldBuildNumber, theJob.oldReleasePath);
+  if (result.deltaPath.isEmpty()) {
+    return result;
+  }
+
+  EdDsaSignatureGenerator signatureGenerator(result.deltaPath, theScheduler->EdDsaKey());
+  result.signature = signatureGenerator.Signature();
+  result.success = !result.signature.isEmpty();
+
+  if (!result.success) {
+    qWarning().noquote().nospace() << "error signing delta - failed to generate EdDSA signature: " << result.deltaPath;
+  }
+  else if (cache != nullptr) {
+    cache->Store(cacheKey, result.deltaPath, result.signature);
+  }
+
+  return result;
+}
+
+static void RunJob(const DeltaScheduler* theScheduler, const DeltaScheduler::Job& theJob, const int theJobIndex, SchedulerState* theState) {
+
+  const DeltaScheduler::Result result = CreateSignedDelta(theScheduler, theJob);
+
+  {
+    QMutexLocker stateLocker(&theState->mutex);
+    theState->results[theJobIndex] = result;
+    theState->finishedJobs.append(theJobIndex);
+  }
+
+  theState->finishedSemaphore.release();
+}
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+
+DeltaScheduler::DeltaScheduler(DeltaSession* theSession, const QByteArray& theEdDsaKey)
+: session(theSession), edDsaKey(theEdDsaKey) {
+
+  Q_ASSERT(session != nullptr);
+
+  maxJobCount = qMax(1, QThread::idealThreadCount());
+  memoryBudget = DefaultMemoryBudget();
+}
+
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+
+qint64 DeltaScheduler::EstimatedJobMemory(const Job& theJob) const {
+
+  return OLD_RELEASE_MEMORY_FACTOR * QFileInfo(theJob.oldReleasePath).size() + QFileInfo(session->NewReleasePath()).size();
+}
+
+#pragma mark Public
+
+qint64 DeltaScheduler::DefaultMemoryBudget() {
+
+  const long pageCount = sysconf(_SC_PHYS_PAGES);
+  const long pageSize = sysconf(_SC_PAGE_SIZE);
+
+  if (pageCount <= 0 || pageSize <= 0) {
+    return 0;
+  }
+
+  return static_cast<qint64>(pageCount) * pageSize / 2;
+}
+
+
+#pragma mark - Mutators -
+
+#pragma mark Public
+
+void DeltaScheduler::SetCache(DeltaCache* theCache) {
+
+  cache = theCache;
+}
+
+void DeltaScheduler::SetMaxJobCount(const int theMaxJobCount) {
+
+  maxJobCount = qMax(1, theMaxJobCount);
+}
+
+void DeltaScheduler::SetMemoryBudget(const qint64 theMemoryBudget) {
+
+  memoryBudget = qMax(Q_INT64_C(0), theMemoryBudget);
+}
+
+QVector<DeltaScheduler::Result> DeltaScheduler::Run(const QVector<Job>& theJobs) {
+
+  QThreadPool threadPool;
+  threadPool.setMaxThreadCount(maxJobCount);
+
+  SchedulerState state;
+  state.results.resize(theJobs.count());
+
+  QVector<qint64> jobMemory(theJobs.count());
+  int runningCount = 0;
+  qint64 runningMemory = 0;
+  int nextJob = 0;
+
+  while (nextJob < theJobs.count() || runningCount > 0) {
+
+    // jobs are started in order, the next one waits until it fits both limits
+    while (nextJob < theJobs.count() && runningCount < maxJobCount) {
+
+      jobMemory[nextJob] = EstimatedJobMemory(theJobs.at(nextJob));
+
+      if (runningCount > 0 && memoryBudget > 0 && runningMemory + jobMemory.at(nextJob) > memoryBudget) {
+        break;
+      }
+
+      QtConcurrent::run(&threadPool, RunJob, static_cast<const DeltaScheduler*>(this), theJobs.at(nextJob), nextJob, &state);
+      runningMemory += jobMemory.at(nextJob);
+      runningCount++;
+      nextJob++;
+    }
+
+    // block until a running job is done
+    state.finishedSemaphore.acquire();
+
+    QMutexLocker stateLocker(&state.mutex);
+    const int finishedJob = state.finishedJobs.takeFirst();
+
+    runningMemory -= jobMemory.at(finishedJob);
+    runningCount--;
+  }
+
+  threadPool.waitForDone();
+
+  return state.results;
+}
@@ -0,0 +1,94 @@
+//
+//  DeltaScheduler.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef DeltaScheduler_hpp
+#define DeltaScheduler_hpp
+
+#include <QObject>
+#include <QVector>
+
+class DeltaCache;
+class DeltaSession;
+
+// runs the delta generation (and EdDSA signing) for several old releases of a DeltaSession concurrently. The
+// number of simultaneous jobs is bounded by the job limit (cores by default) and by a memory budget, which
+// every running job's estimated footprint counts against - a single job is always admitted, however large.
+// Results are returned in job order, regardless of the order the jobs finish in. With a cache set, each job
+// looks its delta up before mounting anything and stores what it generates.
+class DeltaScheduler {
+
+public:
+
+  struct Job {
+    qlonglong oldBuildNumber = -1;
+    QString oldReleasePath;
+  };
+
+  struct Result {
+    qlonglong oldBuildNumber = -1;
+    QString deltaPath;
+    QByteArray signature;
+    bool success = false;
+  };
+
+private:
+
+  DeltaSession* session = nullptr;
+  QByteArray edDsaKey;
+  DeltaCache* cache = nullptr;
+
+  int maxJobCount = 1;
+  qint64 memoryBudget = 0;
+
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+public:
+
+  DeltaScheduler(DeltaSession* theSession, const QByteArray& theEdDsaKey);
+
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+private:
+
+  qint64 EstimatedJobMemory(const Job&) const;
+
+#pragma mark Public
+public:
+
+  // half of the physical memory, or 0 (unbounded) where it can't be determined
+  static qint64 DefaultMemoryBudget();
+
+  DeltaSession* Session() const { return session; }
+  const QByteArray& EdDsaKey() const { return edDsaKey; }
+  DeltaCache* Cache() const { return cache; }
+
+  int MaxJobCount() const { return maxJobCount; }
+  qint64 MemoryBudget() const { return memoryBudget; }
+
+
+#pragma mark - Mutators -
+
+#pragma mark Public
+public:
+
+  // the cache isn't owned, nullptr disables caching
+  void SetCache(DeltaCache*);
+  void SetMaxJobCount(const int);
+
+  // in bytes, 0 disables the budget
+  void SetMemoryBudget(const qint64);
+
+  QVector<Result> Run(const QVector<Job>& theJobs);
+
+};
+
+#endif /* DeltaScheduler_hpp */
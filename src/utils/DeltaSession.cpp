@@ -0,0 +1,139 @@
+//
+//  DeltaSession.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "utils/DeltaSession.hpp"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+
+#include "utils/DeltaGenerator.hpp"
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+
+DeltaSession::DeltaSession(const QString& theNewReleasePath, const qlonglong theNewBuildNumber, const QString& theBundleName)
+: newReleasePath(theNewReleasePath), newBuildNumber(theNewBuildNumber), bundleName(theBundleName) {
+
+}
+
+DeltaSession::~DeltaSession() {
+
+  UnmountRelease(newReleaseMounter);
+
+  // only succeeds once it is empty - a mount point that failed to unmount is left in place
+  QDir().rmdir(ProcessMountDir());
+}
+
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+
+QString DeltaSession::ProcessMountDir() {
+
+  return QString("/tmp/sparkless/%1").arg(QCoreApplication::applicationPid());
+}
+
+QString DeltaSession::MountPointForBuild(const qlonglong theBuildNumber) {
+
+  return QString("%1/%2").arg(ProcessMountDir()).arg(theBuildNumber);
+}
+
+#pragma mark Public
+
+QString DeltaSession::DeltaPathForBuild(const qlonglong theOldBuildNumber) const {
+
+  const QString deltaDir = QString("%1/deltas/%2").arg(QFileInfo(newReleasePath).dir().absolutePath()).arg(newBuildNumber);
+  const QString deltaFilename = QString("%1.%2.%3.delta").arg(QFileInfo(bundleName).completeBaseName()).arg(theOldBuildNumber).arg(newBuildNumber);
+
+  return QString("%1/%2").arg(deltaDir, deltaFilename);
+}
+
+
+#pragma mark - Mutators -
+
+#pragma mark Private
+
+bool DeltaSession::MountRelease(DmgMounter& theMounter, const QString& theReleasePath, const qlonglong theBuildNumber) {
+
+  const QString mountPoint = MountPointForBuild(theBuildNumber);
+  QDir().mkpath(mountPoint);
+
+  theMounter.SetImagePath(theReleasePath);
+  theMounter.SetMountPoint(mountPoint);
+
+  if (!theMounter.Mount()) {
+    qWarning() << "failed to mount image for delta generation: " << theMounter.ImagePath();
+    QDir().rmdir(mountPoint);
+    return false;
+  }
+
+  return true;
+}
+
+void DeltaSession::UnmountRelease(DmgMounter& theMounter) {
+
+  // the (empty) mount point is only removed once nothing is mounted on it anymore
+  if (theMounter.Mounted() && theMounter.Unmount()) {
+    QDir().rmdir(theMounter.MountPoint());
+  }
+}
+
+bool DeltaSession::MountNewRelease() {
+
+  QMutexLocker newReleaseLocker(&newReleaseMutex);
+
+  if (newReleaseMounter.Mounted()) {
+    return true;
+  }
+
+  // a release that failed to mount once isn't retried for every remaining delta
+  if (newReleaseMountFailed) {
+    return false;
+  }
+
+  newReleaseMountFailed = !MountRelease(newReleaseMounter, newReleasePath, newBuildNumber);
+
+  return !newReleaseMountFailed;
+}
+
+#pragma mark Public
+
+QString DeltaSession::CreateDelta(const qlonglong theOldBuildNumber, const QString& theOldReleasePath) {
+
+  if (!MountNewRelease()) {
+    return QString();
+  }
+
+  DmgMounter oldReleaseMounter;
+  if (!MountRelease(oldReleaseMounter, theOldReleasePath, theOldBuildNumber)) {
+    return QString();
+  }
+
+  qInfo().noquote().nospace() << "Generating delta for build " << theOldBuildNumber << " -> " << newBuildNumber << "...";
+
+  const QString oldReleaseBundlePath = QString("%1/%2").arg(oldReleaseMounter.MountPoint(), bundleName);
+  const QString newReleaseBundlePath = QString("%1/%2").arg(newReleaseMounter.MountPoint(), bundleName);
+  const QString deltaPath = DeltaPathForBuild(theOldBuildNumber);
+
+  QDir().mkpath(QFileInfo(deltaPath).absolutePath());
+
+  DeltaGenerator deltaGenerator(oldReleaseBundlePath, newReleaseBundlePath, deltaPath);
+
+  UnmountRelease(oldReleaseMounter);
+
+  if (!deltaGenerator.Success()) {
+    qWarning().noquote().nospace() << "failed to make delta: " << deltaPath;
+    return QString();
+  }
+
+  return deltaPath;
+}
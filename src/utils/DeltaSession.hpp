@@ -0,0 +1,85 @@
+//
+//  DeltaSession.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef DeltaSession_hpp
+#define DeltaSession_hpp
+
+#include <QObject>
+#include <QMutex>
+
+#include "utils/DmgMounter.hpp"
+
+// generates the deltas from any number of old releases to one new release. The new release's dmg is only
+// mounted once (on the first delta) and is unmounted when the session is destroyed, old releases are mounted
+// for the duration of their own delta. Mount points are private to the process, so a stale mount left behind
+// by an earlier run can't collide with them.
+class DeltaSession {
+
+private:
+
+  QString newReleasePath;
+  qlonglong newBuildNumber = -1;
+  QString bundleName;
+
+  // CreateDelta() may run on several threads at once (see DeltaScheduler)
+  QMutex newReleaseMutex;
+  DmgMounter newReleaseMounter;
+  bool newReleaseMountFailed = false;
+
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+public:
+
+  // theBundleName is the app's file name inside each dmg (e.g. "Sparkless.app")
+  DeltaSession(const QString& theNewReleasePath, const qlonglong theNewBuildNumber, const QString& theBundleName);
+  ~DeltaSession();
+
+private:
+
+  Q_DISABLE_COPY(DeltaSession)
+
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+private:
+
+  // /tmp/sparkless/<pid>, the parent of every mount point created by this process
+  static QString ProcessMountDir();
+  static QString MountPointForBuild(const qlonglong theBuildNumber);
+
+#pragma mark Public
+public:
+
+  const QString& NewReleasePath() const { return newReleasePath; }
+  qlonglong NewBuildNumber() const { return newBuildNumber; }
+
+  QString DeltaPathForBuild(const qlonglong theOldBuildNumber) const;
+
+
+#pragma mark - Mutators -
+
+#pragma mark Private
+private:
+
+  static bool MountRelease(DmgMounter& theMounter, const QString& theReleasePath, const qlonglong theBuildNumber);
+  static void UnmountRelease(DmgMounter& theMounter);
+
+  bool MountNewRelease();
+
+#pragma mark Public
+public:
+
+  // returns the path of the generated delta, or an empty string on failure
+  QString CreateDelta(const qlonglong theOldBuildNumber, const QString& theOldReleasePath);
+
+};
+
+#endif /* DeltaSession_hpp */
@@ -27,6 +27,14 @@ DmgMounter::DmgMounter(const QString& theImagePath, const QString& theMountPoint
   SetMountPoint(theMountPoint);
 }
 
+DmgMounter::~DmgMounter() {
+
+  // images are never left attached, whichever path the owner returns through
+  if (mounted) {
+    Unmount();
+  }
+}
+
 
 #pragma mark - Accessors -
 
@@ -96,11 +104,12 @@ bool DmgMounter::Mount() {
 
     commandOutput = hdiutilProcess.readAllStandardOutput();
 
-    if (hdiutilProcess.exitStatus() == QProcess::NormalExit) {
+    if (hdiutilProcess.exitStatus() == QProcess::NormalExit && hdiutilProcess.exitCode() == 0) {
       mounted = true;
       success =  true;
     }
     else {
+      qWarning().noquote().nospace() << "hdiutil mount had a non-zero exit code - output: " << commandOutput;
       success = false;
     }
   }
@@ -147,7 +156,7 @@ bool DmgMounter::Unmount() {
 
     commandOutput = hdiutilProcess.readAllStandardOutput();
 
-    if (hdiutilProcess.exitStatus() == QProcess::NormalExit) {
+    if (hdiutilProcess.exitStatus() == QProcess::NormalExit && hdiutilProcess.exitCode() == 0) {
       mounted = false;
       success =  true;
     }
@@ -31,6 +31,11 @@ public:
 
   DmgMounter();
   DmgMounter(const QString& theImagePath, const QString& theMountPoint);
+  ~DmgMounter();
+
+private:
+
+  Q_DISABLE_COPY(DmgMounter)
 
 
 #pragma mark - Accessors -
@@ -7,11 +7,82 @@
 //
 
 #include "utils/DsaSignatureGenerator.hpp"
+#include "utils/FileDigests.hpp"
+#include "utils/SignatureCache.hpp"
 
 #include <QCoreApplication>
+#include <QCryptographicHash>
 #include <QDebug>
-#include <QProcess>
+#include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QProcess>
+#include <QScopedPointer>
+#include <QSet>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+struct EvpMdCtxDeleter {
+  static void cleanup(EVP_MD_CTX* theContext) { EVP_MD_CTX_free(theContext); }
+};
+
+struct BioDeleter {
+  static void cleanup(BIO* theBio) { BIO_free(theBio); }
+};
+
+// refuses to prompt for a passphrase, encrypted keys fail to load instead
+static int NoPassphrase(char*, int, int, void*) {
+
+  return 0;
+}
+
+// keys are parsed on first use and kept for the lifetime of the process, so every bundle (and thread) of a run
+// shares them. Keys that failed to load are remembered as nullptr, and are left to the helper. Keys that loaded
+// but aren't DSA keys set theKeyRejected - those can't produce a valid signature either way
+static EVP_PKEY* PrivateKeyForPath(const QString& theKeyPath, bool& theKeyRejected) {
+
+  static QMutex keysMutex;
+  static QHash<QString, EVP_PKEY*> keys;
+  static QSet<QString> rejectedKeyPaths;
+
+  const QString keyPath = QFileInfo(theKeyPath).absoluteFilePath();
+
+  QMutexLocker keysLocker(&keysMutex);
+
+  theKeyRejected = rejectedKeyPaths.contains(keyPath);
+
+  if (keys.contains(keyPath)) {
+    return keys.value(keyPath);
+  }
+
+  EVP_PKEY* privateKey = nullptr;
+
+  QFile keyFile(keyPath);
+  if (keyFile.open(QIODevice::ReadOnly)) {
+
+    const QByteArray keyPem = keyFile.readAll();
+
+    QScopedPointer<BIO, BioDeleter> keyBio(BIO_new_mem_buf(keyPem.constData(), keyPem.size()));
+    if (!keyBio.isNull()) {
+      privateKey = PEM_read_bio_PrivateKey(keyBio.data(), nullptr, NoPassphrase, nullptr);
+    }
+  }
+
+  if (privateKey != nullptr && EVP_PKEY_base_id(privateKey) != EVP_PKEY_DSA) {
+    qWarning() << "Error loading dsa key - not a DSA private key: " << keyPath;
+    EVP_PKEY_free(privateKey);
+    privateKey = nullptr;
+
+    rejectedKeyPaths.insert(keyPath);
+    theKeyRejected = true;
+  }
+
+  keys.insert(keyPath, privateKey);
+
+  return privateKey;
+}
 
 #pragma mark - Constructors -
 
@@ -30,6 +101,7 @@ DsaSignatureGenerator::DsaSignatureGenerator(const QString& theBinaryPath, const
 }
 
 
+
 #pragma mark - Accessors -
 
 #pragma mark Private
@@ -39,25 +111,51 @@ QString DsaSignatureGenerator::GenerateSignatureProgramPath() {
   return QString("%1/%2").arg(HelperScriptsDir(), "sign_update_DSA");
 }
 
+QByteArray DsaSignatureGenerator::KeyFingerprint() const {
+
+  QFile keyFile(dsaKeyPath);
+  if (!keyFile.open(QIODevice::ReadOnly)) {
+    return QByteArray();
+  }
+
+  return QCryptographicHash::hash(keyFile.readAll(), QCryptographicHash::Sha256).toHex();
+}
+
 
 #pragma mark - Mutators -
 
-#pragma mark Public
+#pragma mark Private
 
-void DsaSignatureGenerator::SetBinaryPath(const QString& thePath) {
+bool DsaSignatureGenerator::GenerateSignatureNatively(const QByteArray& theBinaryDigest) {
 
-  binaryPath = thePath;
-}
+  bool keyRejected = false;
+  EVP_PKEY* privateKey = PrivateKeyForPath(dsaKeyPath, keyRejected);
+  Q_ASSERT(privateKey != nullptr);
+  Q_ASSERT(!theBinaryDigest.isEmpty());
 
-void DsaSignatureGenerator::SetDsaKeyPath(const QString& thePath) {
+  // theBinaryDigest is `openssl dgst -sha1 -binary < binary`
+  // | openssl dgst -sha1 -sign key - the digest is hashed again before signing, as Sparkle expects
+  QScopedPointer<EVP_MD_CTX, EvpMdCtxDeleter> signContext(EVP_MD_CTX_new());
 
-  dsaKeyPath = thePath;
-}
+  QByteArray rawSignature(EVP_PKEY_size(privateKey), '\0');
+  size_t rawSignatureSize = static_cast<size_t>(rawSignature.size());
 
-bool DsaSignatureGenerator::GenerateSignature() {
+  if (signContext.isNull()
+      || EVP_DigestSignInit(signContext.data(), nullptr, EVP_sha1(), nullptr, privateKey) != 1
+      || EVP_DigestSign(signContext.data(), reinterpret_cast<unsigned char*>(rawSignature.data()), &rawSignatureSize, reinterpret_cast<const unsigned char*>(theBinaryDigest.constData()), static_cast<size_t>(theBinaryDigest.size())) != 1) {
+    qWarning() << "Error generating dsa signature - signing failed for: " << binaryPath;
+    return false;
+  }
 
-  // reset signature value
-  signature = QByteArray();
+  rawSignature.truncate(static_cast<int>(rawSignatureSize));
+
+  // | openssl enc -base64 (unwrapped, the helper's line breaks were only ever folded into spaces)
+  signature = rawSignature.toBase64();
+
+  return true;
+}
+
+bool DsaSignatureGenerator::GenerateSignatureWithHelper() {
 
   const QString generatePath = GenerateSignatureProgramPath();
 
@@ -65,14 +163,6 @@ bool DsaSignatureGenerator::GenerateSignature() {
     qFatal("Could not find dsa signature generator program at expected path: %s", generatePath.toLatin1().constData());
     return false;
   }
-  if (!QFileInfo::exists(binaryPath)) {
-    qWarning() << "Error generating dsa signature - binary doesn't exist: " << binaryPath;
-    return false;
-  }
-  if (!QFileInfo::exists(dsaKeyPath)) {
-    qWarning() << "Error generating dsa signature - DSA key file doesn't exist: " + dsaKeyPath;
-    return false;
-  }
 
   const QStringList generateArgs = {
     binaryPath,
@@ -114,6 +204,98 @@ bool DsaSignatureGenerator::GenerateSignature() {
     }
   }
 
+  return success;
+}
+
+#pragma mark Public
+
+void DsaSignatureGenerator::SetBinaryPath(const QString& thePath) {
+
+  binaryPath = thePath;
+}
+
+void DsaSignatureGenerator::SetDsaKeyPath(const QString& thePath) {
+
+  dsaKeyPath = thePath;
+}
+
+bool DsaSignatureGenerator::GenerateSignature() {
+
+  // reset signature value
+  signature = QByteArray();
+  binarySize = -1;
+
+  if (!QFileInfo::exists(binaryPath)) {
+    qWarning() << "Error generating dsa signature - binary doesn't exist: " << binaryPath;
+    return false;
+  }
+  if (!QFileInfo::exists(dsaKeyPath)) {
+    qWarning() << "Error generating dsa signature - DSA key file doesn't exist: " + dsaKeyPath;
+    return false;
+  }
+
+  bool keyRejected = false;
+  const bool signsNatively = (PrivateKeyForPath(dsaKeyPath, keyRejected) != nullptr);
+
+  // e.g. an EdDSA or RSA key passed as the DSA key - signing it with the helper wouldn't produce a DSA signature
+  if (keyRejected) {
+    qWarning() << "Error generating dsa signature - specified key is not a DSA key: " << dsaKeyPath;
+    success = false;
+    return success;
+  }
+
+  // taken before anything is read, a signature is only stored if the binary is still the same afterwards
+  const SignatureCache::FileIdentity binaryIdentity = SignatureCache::IdentityForPath(binaryPath);
+  const QByteArray keyFingerprint = KeyFingerprint();
+  const bool usesCache = SignatureCache::Enabled() && !keyFingerprint.isEmpty();
+
+  // the stat fields alone can be conclusive, in which case the binary isn't read at all
+  if (usesCache) {
+
+    signature = SignatureCache::Lookup(binaryIdentity, keyFingerprint, DsaSignature);
+
+    if (!signature.isEmpty()) {
+      binarySize = binaryIdentity.size;
+      success = true;
+      return success;
+    }
+  }
+
+  // one read provides the sha1 to sign and the sha256 the cache is validated against
+  const int requiredDigests = (signsNatively ? FileDigests::Sha1Digest : 0) | (usesCache ? FileDigests::Sha256Digest : 0);
+  QByteArray binaryDigest;
+  QByteArray binarySha256;
+
+  if (requiredDigests != 0) {
+
+    const FileDigests binaryDigests(binaryPath, requiredDigests);
+    if (!binaryDigests.Success()) {
+      qWarning() << "Error generating dsa signature - failed to read binary: " << binaryPath;
+      success = false;
+      return success;
+    }
+
+    binarySize = binaryDigests.Size();
+    binaryDigest = binaryDigests.Sha1();
+    binarySha256 = binaryDigests.Sha256();
+  }
+
+  if (usesCache) {
+    signature = SignatureCache::Lookup(binaryIdentity, keyFingerprint, DsaSignature, binarySha256);
+  }
+
+  if (!signature.isEmpty()) {
+    success = true;
+  }
+  else {
+    success = signsNatively ? GenerateSignatureNatively(binaryDigest) : GenerateSignatureWithHelper();
+  }
+
+  // a content hit is refreshed with the current stat fields, so the next run can skip the read
+  if (success && usesCache && SignatureCache::IdentityForPath(binaryPath) == binaryIdentity) {
+    SignatureCache::Store(binaryIdentity, keyFingerprint, DsaSignature, binarySha256, signature);
+  }
+
   if (!success) {
     qWarning() << "DSA signature generation failed";
   }
@@ -13,6 +13,11 @@
 
 #include "Constants.hpp"
 
+// signs a file the way Sparkle's sign_update_DSA does (base64 of the DSA signature over the sha1 of the file's
+// sha1), in process through OpenSSL. The file is read once, and each PEM key is parsed once per run. Keys
+// OpenSSL can't load without a prompt (e.g. encrypted ones) are still passed to the helper script. Signatures
+// are looked up in (and added to) the SignatureCache first - a hit on the stat fields alone doesn't read the
+// file at all.
 class DsaSignatureGenerator {
 
 private:
@@ -21,6 +26,7 @@ private:
   QString dsaKeyPath;
 
   QByteArray signature;
+  qint64 binarySize = -1;
 
   bool success = false;
   QByteArray commandOutput;
@@ -42,6 +48,8 @@ private:
 
 static QString GenerateSignatureProgramPath();
 
+  QByteArray KeyFingerprint() const;
+
 #pragma mark Public
 public:
 
@@ -53,9 +61,18 @@ public:
   const QByteArray& CommandOutput() const { return commandOutput; }
   const QByteArray& Signature() const { return signature; }
 
+  // the length of the binary that was signed (from the read, or the cache entry), -1 if it wasn't read
+  qint64 BinarySize() const { return binarySize; }
+
 
 #pragma mark - Mutators -
 
+#pragma mark Private
+private:
+
+  bool GenerateSignatureNatively(const QByteArray& theBinaryDigest);
+  bool GenerateSignatureWithHelper();
+
 #pragma mark Public
 public:
 
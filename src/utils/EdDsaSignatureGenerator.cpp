@@ -7,11 +7,74 @@
 //
 
 #include "EdDsaSignatureGenerator.hpp"
+#include "utils/SignatureCache.hpp"
 
 #include <QCoreApplication>
+#include <QCryptographicHash>
 #include <QDebug>
+#include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QMutex>
 #include <QProcess>
+#include <QScopedPointer>
+
+#include <openssl/evp.h>
+
+static const int ED25519_SEED_SIZE = 32;
+static const int ED25519_SIGNATURE_SIZE = 64;
+
+// QCryptographicHash::addData() takes an int length
+static const qint64 HASH_CHUNK_SIZE = 64 * 1024 * 1024;
+
+struct EvpMdCtxDeleter {
+  static void cleanup(EVP_MD_CTX* theContext) { EVP_MD_CTX_free(theContext); }
+};
+
+static QMutex privateKeysMutex;
+static QHash<QByteArray, EVP_PKEY*> privateKeys;
+
+// registered with qAddPostRoutine(), so the keys are released before OpenSSL cleans up at exit
+static void FreePrivateKeys() {
+
+  QMutexLocker keysLocker(&privateKeysMutex);
+
+  foreach (EVP_PKEY* currKey, privateKeys) {
+    EVP_PKEY_free(currKey);
+  }
+  privateKeys.clear();
+}
+
+// keys are parsed on first use and kept until the application exits, so every bundle (and thread) of a run
+// shares them, as in DsaSignatureGenerator. Seeds that failed to load are remembered as nullptr
+static EVP_PKEY* PrivateKeyForSeed(const QByteArray& theKeySeed) {
+
+  QMutexLocker keysLocker(&privateKeysMutex);
+
+  if (privateKeys.contains(theKeySeed)) {
+    return privateKeys.value(theKeySeed);
+  }
+
+  if (privateKeys.isEmpty()) {
+    qAddPostRoutine(FreePrivateKeys);
+  }
+
+  EVP_PKEY* privateKey = EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, nullptr, reinterpret_cast<const unsigned char*>(theKeySeed.constData()), theKeySeed.size());
+  privateKeys.insert(theKeySeed, privateKey);
+
+  return privateKey;
+}
+
+static QByteArray Sha256ForData(const uchar* theData, const qint64 theSize) {
+
+  QCryptographicHash sha256Hash(QCryptographicHash::Sha256);
+
+  for (qint64 offset = 0; offset < theSize; offset += HASH_CHUNK_SIZE) {
+    sha256Hash.addData(reinterpret_cast<const char*>(theData + offset), static_cast<int>(qMin(HASH_CHUNK_SIZE, theSize - offset)));
+  }
+
+  return sha256Hash.result();
+}
 
 #pragma mark - Constructors -
 
@@ -40,24 +103,46 @@ QString EdDsaSignatureGenerator::GenerateSignatureProgramPath() {
 }
 
 
+QByteArray EdDsaSignatureGenerator::NativeKeySeed() const {
+
+  // generate_keys exports the base64 seed. Older (96 byte) keys hold the expanded private key instead, which
+  // OpenSSL can't import
+  const QByteArray keySeed = QByteArray::fromBase64(edDsaKey);
+
+  return (keySeed.size() == ED25519_SEED_SIZE) ? keySeed : QByteArray();
+}
+
+
 #pragma mark - Mutators -
 
-#pragma mark Public
+#pragma mark Private
 
-void EdDsaSignatureGenerator::SetBinaryPath(const QString& thePath) {
+bool EdDsaSignatureGenerator::GenerateSignatureNatively(const QByteArray& theKeySeed, const uchar* theBinaryData, const qint64 theBinarySize) {
 
-  binaryPath = thePath;
-}
+  EVP_PKEY* privateKey = PrivateKeyForSeed(theKeySeed);
+  if (privateKey == nullptr) {
+    qWarning() << "Error generating Ed25519 signature - failed to load the private key";
+    return false;
+  }
 
-void EdDsaSignatureGenerator::SetEdDsaKey(const QByteArray& theKey) {
+  QScopedPointer<EVP_MD_CTX, EvpMdCtxDeleter> signContext(EVP_MD_CTX_new());
 
-  edDsaKey = theKey;
-}
+  unsigned char rawSignature[ED25519_SIGNATURE_SIZE];
+  size_t rawSignatureSize = sizeof(rawSignature);
 
-bool EdDsaSignatureGenerator::GenerateSignature() {
+  if (signContext.isNull()
+      || EVP_DigestSignInit(signContext.data(), nullptr, nullptr, nullptr, privateKey) != 1
+      || EVP_DigestSign(signContext.data(), rawSignature, &rawSignatureSize, theBinaryData, static_cast<size_t>(theBinarySize)) != 1) {
+    qWarning() << "Error generating Ed25519 signature - signing failed for: " << binaryPath;
+    return false;
+  }
 
-  // reset signature value
-  signature = QByteArray();
+  signature = QByteArray(reinterpret_cast<const char*>(rawSignature), static_cast<int>(rawSignatureSize)).toBase64();
+
+  return true;
+}
+
+bool EdDsaSignatureGenerator::GenerateSignatureWithHelper() {
 
   const QString generatePath = GenerateSignatureProgramPath();
 
@@ -65,14 +150,6 @@ bool EdDsaSignatureGenerator::GenerateSignature() {
     qFatal("Could not find Ed25519 signature generator program at expected path: %s", generatePath.toLatin1().constData());
     return false;
   }
-  if (!QFileInfo::exists(binaryPath)) {
-    qWarning() << "Error generating Ed25519 signature - binary doesn't exist: " << binaryPath;
-    return false;
-  }
-  if (edDsaKey.isEmpty()) {
-    qWarning() << "Error generating Ed25519 signature - specified key is empty";
-    return false;
-  }
 
   const QStringList generateArgs = {
     "-s", edDsaKey,
@@ -118,10 +195,101 @@ bool EdDsaSignatureGenerator::GenerateSignature() {
     }
   }
 
+  return success;
+}
+
+#pragma mark Public
+
+void EdDsaSignatureGenerator::SetBinaryPath(const QString& thePath) {
+
+  binaryPath = thePath;
+}
+
+void EdDsaSignatureGenerator::SetEdDsaKey(const QByteArray& theKey) {
+
+  edDsaKey = theKey;
+}
+
+bool EdDsaSignatureGenerator::GenerateSignature() {
+
+  // reset signature value
+  signature = QByteArray();
+
+  if (!QFileInfo::exists(binaryPath)) {
+    qWarning() << "Error generating Ed25519 signature - binary doesn't exist: " << binaryPath;
+    return false;
+  }
+  if (edDsaKey.isEmpty()) {
+    qWarning() << "Error generating Ed25519 signature - specified key is empty";
+    return false;
+  }
+
+  // taken before anything is read, a signature is only stored if the binary is still the same afterwards
+  const SignatureCache::FileIdentity binaryIdentity = SignatureCache::IdentityForPath(binaryPath);
+  const QByteArray keyFingerprint = QCryptographicHash::hash(edDsaKey, QCryptographicHash::Sha256).toHex();
+  const bool usesCache = SignatureCache::Enabled();
+
+  // the stat fields alone can be conclusive, in which case the binary isn't read at all
+  if (usesCache) {
+
+    signature = SignatureCache::Lookup(binaryIdentity, keyFingerprint, Ed25519Signature);
+
+    if (!signature.isEmpty()) {
+      success = true;
+      return success;
+    }
+  }
+
+  const QByteArray keySeed = NativeKeySeed();
+
+  // Ed25519 can't sign a stream (the message is hashed twice), mapping the file avoids buffering a copy of it.
+  // The cache's sha256 is taken from the same mapping, so it always describes the bytes that were signed
+  QFile binaryFile(binaryPath);
+  const uchar* binaryData = nullptr;
+  qint64 binarySize = 0;
+
+  if (usesCache || !keySeed.isEmpty()) {
+
+    if (!binaryFile.open(QIODevice::ReadOnly)) {
+      qWarning() << "Error generating Ed25519 signature - failed to open binary: " << binaryPath;
+      success = false;
+      return success;
+    }
+
+    binarySize = binaryFile.size();
+
+    if (binarySize > 0) {
+      binaryData = binaryFile.map(0, binarySize);
+      if (binaryData == nullptr) {
+        qWarning() << "Error generating Ed25519 signature - failed to map binary: " << binaryPath;
+        success = false;
+        return success;
+      }
+    }
+  }
+
+  QByteArray binarySha256;
+
+  if (usesCache) {
+    binarySha256 = Sha256ForData(binaryData, binarySize);
+    signature = SignatureCache::Lookup(binaryIdentity, keyFingerprint, Ed25519Signature, binarySha256);
+  }
+
+  if (!signature.isEmpty()) {
+    success = true;
+  }
+  else {
+    success = keySeed.isEmpty() ? GenerateSignatureWithHelper() : GenerateSignatureNatively(keySeed, binaryData, binarySize);
+  }
+
+  // a content hit is refreshed with the current stat fields, so the next run can skip the read
+  if (success && usesCache && SignatureCache::IdentityForPath(binaryPath) == binaryIdentity) {
+    SignatureCache::Store(binaryIdentity, keyFingerprint, Ed25519Signature, binarySha256, signature);
+  }
+
   if (!success) {
     qWarning() << "EdDSA signature generation failed";
   }
 
-  return false;
+  return success;
 }
-
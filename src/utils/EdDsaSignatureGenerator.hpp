@@ -13,6 +13,10 @@
 
 #include "Constants.hpp"
 
+// signs a file with an Ed25519 key, in process (through OpenSSL) for the 32 byte seeds written by Sparkle's
+// generate_keys. The file is mapped rather than read, as Ed25519 hashes the whole message twice - the same
+// mapping provides the sha256 for the SignatureCache, which is consulted first. Keys in any other format are
+// still passed to the sign_update_EdDSA helper.
 class EdDsaSignatureGenerator {
 
 private:
@@ -42,6 +46,9 @@ private:
 
 static QString GenerateSignatureProgramPath();
 
+  // the raw private key (seed) if edDsaKey is one OpenSSL can sign with, otherwise empty
+  QByteArray NativeKeySeed() const;
+
 #pragma mark Public
 public:
 
@@ -56,6 +63,12 @@ public:
 
 #pragma mark - Mutators -
 
+#pragma mark Private
+private:
+
+  bool GenerateSignatureNatively(const QByteArray& theKeySeed, const uchar* theBinaryData, const qint64 theBinarySize);
+  bool GenerateSignatureWithHelper();
+
 #pragma mark Public
 public:
 
@@ -0,0 +1,129 @@
+//
+//  FeedCompressor.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "utils/FeedCompressor.hpp"
+
+#include <QDebug>
+
+#include <cstring>
+#include <zlib.h>
+#include <zstd.h>
+
+// ZSTD_compress2 and the ZSTD_CCtx_setParameter api are stable from 1.4.0
+#if ZSTD_VERSION_NUMBER < 10400
+  #error "sparkless requires zstd 1.4.0 or newer"
+#endif
+
+static const int GZIP_MAX_LEVEL = 9;
+static const int ZSTD_MAX_LEVEL = 19;    // levels above 19 ("ultra") need far more memory to decompress
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+
+QByteArray FeedCompressor::CompressGzip(const QByteArray& theData, const int theLevel) {
+
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+
+  // window bits + 16 selects the gzip wrapper
+  if (deflateInit2(&stream, theLevel, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    qWarning().noquote().nospace() << "error compressing appcast - unable to initialize gzip stream";
+    return QByteArray();
+  }
+
+  QByteArray compressedData;
+  compressedData.resize(static_cast<int>(deflateBound(&stream, static_cast<uLong>(theData.size()))));
+
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(theData.constData()));
+  stream.avail_in = static_cast<uInt>(theData.size());
+  stream.next_out = reinterpret_cast<Bytef*>(compressedData.data());
+  stream.avail_out = static_cast<uInt>(compressedData.size());
+
+  const int result = deflate(&stream, Z_FINISH);
+  const uLong compressedSize = stream.total_out;
+
+  deflateEnd(&stream);
+
+  if (result != Z_STREAM_END) {
+    qWarning().noquote().nospace() << "error compressing appcast - gzip error " << result;
+    return QByteArray();
+  }
+
+  compressedData.resize(static_cast<int>(compressedSize));
+
+  return compressedData;
+}
+
+QByteArray FeedCompressor::CompressZstd(const QByteArray& theData, const int theLevel) {
+
+  ZSTD_CCtx* context = ZSTD_createCCtx();
+  if (context == nullptr) {
+    qWarning().noquote().nospace() << "error compressing appcast - unable to create zstd context";
+    return QByteArray();
+  }
+
+  // single threaded in-process compression, so the output doesn't depend on how libzstd was built. The
+  // feeds and formats are already compressed in parallel by the caller
+  size_t parameterResult = ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, theLevel);
+  if (!ZSTD_isError(parameterResult)) {
+    parameterResult = ZSTD_CCtx_setParameter(context, ZSTD_c_nbWorkers, 0);
+  }
+
+  if (ZSTD_isError(parameterResult)) {
+    qWarning().noquote().nospace() << "error compressing appcast - " << ZSTD_getErrorName(parameterResult);
+    ZSTD_freeCCtx(context);
+    return QByteArray();
+  }
+
+  QByteArray compressedData;
+  compressedData.resize(static_cast<int>(ZSTD_compressBound(static_cast<size_t>(theData.size()))));
+
+  const size_t compressedSize = ZSTD_compress2(context, compressedData.data(), static_cast<size_t>(compressedData.size()), theData.constData(), static_cast<size_t>(theData.size()));
+
+  ZSTD_freeCCtx(context);
+
+  if (ZSTD_isError(compressedSize)) {
+    qWarning().noquote().nospace() << "error compressing appcast - " << ZSTD_getErrorName(compressedSize);
+    return QByteArray();
+  }
+
+  compressedData.resize(static_cast<int>(compressedSize));
+
+  return compressedData;
+}
+
+#pragma mark Public
+
+QString FeedCompressor::Extension(const Format theFormat) {
+
+  switch (theFormat) {
+    case GzipFormat: {
+      return ".gz";
+    }
+    case ZstdFormat: {
+      return ".zst";
+    }
+  }
+
+  return QString();
+}
+
+QByteArray FeedCompressor::Compress(const QByteArray& theData, const Format theFormat, const int theLevel) {
+
+  switch (theFormat) {
+    case GzipFormat: {
+      return CompressGzip(theData, (theLevel == DEFAULT_LEVEL) ? GZIP_MAX_LEVEL : qBound(1, theLevel, GZIP_MAX_LEVEL));
+    }
+    case ZstdFormat: {
+      return CompressZstd(theData, (theLevel == DEFAULT_LEVEL) ? ZSTD_MAX_LEVEL : qBound(1, theLevel, ZSTD_MAX_LEVEL));
+    }
+  }
+
+  return QByteArray();
+}
@@ -0,0 +1,49 @@
+//
+//  FeedCompressor.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef FeedCompressor_hpp
+#define FeedCompressor_hpp
+
+#include <QByteArray>
+#include <QString>
+
+// precompresses appcast xml for static hosting (object storage/cdn), so that compressed bodies can be served
+// without any per-request cpu. Gzip output is byte-stable (no mtime or file name in the header).
+class FeedCompressor {
+
+public:
+
+  enum Format {
+    GzipFormat = 0,
+    ZstdFormat,
+  };
+
+  static const int DEFAULT_LEVEL = -1;
+
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+private:
+
+  static QByteArray CompressGzip(const QByteArray& theData, const int theLevel);
+  static QByteArray CompressZstd(const QByteArray& theData, const int theLevel);
+
+#pragma mark Public
+public:
+
+  // e.g. ".gz", appended to the uncompressed file's path
+  static QString Extension(const Format);
+
+  // theLevel is clamped to the format's range (gzip 1-9, zstd 1-19), DEFAULT_LEVEL selects the format's
+  // maximum since every output is compressed once and downloaded many times. Returns a null byte array on failure
+  static QByteArray Compress(const QByteArray& theData, const Format, const int theLevel = DEFAULT_LEVEL);
+
+};
+
+#endif /* FeedCompressor_hpp */
@@ -0,0 +1,119 @@
+//
+//  FileDigests.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "utils/FileDigests.hpp"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFile>
+#include <QFuture>
+#include <QtConcurrent>
+
+#ifdef Q_OS_LINUX
+  #include <fcntl.h>
+#endif
+
+// a multiple of the page size, so every read starts on a page boundary of the file
+static const qint64 CHUNK_SIZE = 4 * 1024 * 1024;
+
+static void AddChunk(QCryptographicHash* theHash, const QByteArray* theChunk) {
+
+  theHash->addData(*theChunk);
+}
+
+static bool ReadChunk(QFile& theFile, QByteArray& theChunk) {
+
+  theChunk.resize(static_cast<int>(CHUNK_SIZE));
+
+  const qint64 readSize = theFile.read(theChunk.data(), CHUNK_SIZE);
+  if (readSize < 0) {
+    return false;
+  }
+
+  theChunk.resize(static_cast<int>(readSize));
+
+  return true;
+}
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+
+FileDigests::FileDigests(const QString& theFilePath, const int theDigests)
+: filePath(theFilePath), digests(theDigests & AllDigests) {
+
+  success = Scan();
+}
+
+
+#pragma mark - Mutators -
+
+#pragma mark Private
+
+bool FileDigests::Scan() {
+
+  // unbuffered, chunks are read straight into our own buffers
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+    qWarning().noquote().nospace() << "error scanning file - failed to open: " << filePath;
+    return false;
+  }
+
+#ifdef Q_OS_LINUX
+  posix_fadvise(file.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  QList<QCryptographicHash*> hashes;
+  QCryptographicHash* sha1Hash = (digests & Sha1Digest) ? new QCryptographicHash(QCryptographicHash::Sha1) : nullptr;
+  QCryptographicHash* sha256Hash = (digests & Sha256Digest) ? new QCryptographicHash(QCryptographicHash::Sha256) : nullptr;
+  QCryptographicHash* sha512Hash = (digests & Sha512Digest) ? new QCryptographicHash(QCryptographicHash::Sha512) : nullptr;
+
+  foreach (QCryptographicHash* currHash, QList<QCryptographicHash*>() << sha1Hash << sha256Hash << sha512Hash) {
+    if (currHash != nullptr) {
+      hashes.append(currHash);
+    }
+  }
+
+  // double buffered - chunk n is hashed while chunk n+1 is read
+  QByteArray chunks[2];
+  int currChunk = 0;
+  qint64 scannedSize = 0;
+
+  bool readOk = ReadChunk(file, chunks[currChunk]);
+
+  while (readOk && !chunks[currChunk].isEmpty()) {
+
+    QList<QFuture<void> > hashFutures;
+    foreach (QCryptographicHash* currHash, hashes) {
+      hashFutures.append(QtConcurrent::run(AddChunk, currHash, &chunks[currChunk]));
+    }
+
+    readOk = ReadChunk(file, chunks[1 - currChunk]);
+
+    for (int futureIndex = 0; futureIndex < hashFutures.count(); futureIndex++) {
+      hashFutures[futureIndex].waitForFinished();
+    }
+
+    scannedSize += chunks[currChunk].size();
+    currChunk = 1 - currChunk;
+  }
+
+  if (readOk) {
+    size = scannedSize;
+    sha1 = (sha1Hash != nullptr) ? sha1Hash->result() : QByteArray();
+    sha256 = (sha256Hash != nullptr) ? sha256Hash->result() : QByteArray();
+    sha512 = (sha512Hash != nullptr) ? sha512Hash->result() : QByteArray();
+  }
+  else {
+    qWarning().noquote().nospace() << "error scanning file - failed to read: " << filePath;
+  }
+
+  qDeleteAll(hashes);
+
+  return readOk;
+}
@@ -0,0 +1,77 @@
+//
+//  FileDigests.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef FileDigests_hpp
+#define FileDigests_hpp
+
+#include <QObject>
+
+// reads a file exactly once, in large chunks, and feeds every requested digest (and the length) from the same
+// pass. The digests of one chunk are computed concurrently while the next chunk is being read, so signing and
+// caching a multi-gigabyte bundle costs one sequential read instead of one per consumer.
+class FileDigests {
+
+public:
+
+  enum Digest {
+    Sha1Digest    = 1 << 0,
+    Sha256Digest  = 1 << 1,
+    Sha512Digest  = 1 << 2,
+    AllDigests    = Sha1Digest | Sha256Digest | Sha512Digest,
+  };
+
+private:
+
+  QString filePath;
+  int digests = 0;
+
+  qint64 size = -1;
+  QByteArray sha1;
+  QByteArray sha256;
+  QByteArray sha512;
+
+  bool success = false;
+
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+public:
+
+  explicit FileDigests(const QString& theFilePath, const int theDigests = AllDigests);
+
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+public:
+
+  const QString& FilePath() const { return filePath; }
+  int Digests() const { return digests; }
+
+  // the number of bytes actually read, -1 on failure
+  qint64 Size() const { return size; }
+
+  // raw (binary) digests, empty if not requested or on failure
+  const QByteArray& Sha1() const { return sha1; }
+  const QByteArray& Sha256() const { return sha256; }
+  const QByteArray& Sha512() const { return sha512; }
+
+  bool Success() const { return success; }
+
+
+#pragma mark - Mutators -
+
+#pragma mark Private
+private:
+
+  bool Scan();
+
+};
+
+#endif /* FileDigests_hpp */
@@ -0,0 +1,157 @@
+//
+//  MonotonicArena.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "utils/MonotonicArena.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+const std::size_t MonotonicArena::DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+// every ArenaAllocated object is preceded by the arena it came from (nullptr for heap allocations)
+static const std::size_t ALLOCATION_HEADER_SIZE = alignof(std::max_align_t) > sizeof(MonotonicArena*) ? alignof(std::max_align_t) : sizeof(MonotonicArena*);
+
+static thread_local MonotonicArena* currentArena = nullptr;
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+
+MonotonicArena::MonotonicArena(const std::size_t theBlockSize)
+: blockSize(theBlockSize) {
+
+}
+
+MonotonicArena::~MonotonicArena() {
+
+  Release();
+}
+
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+
+MonotonicArena* MonotonicArena::Current() {
+
+  return currentArena;
+}
+
+
+#pragma mark - Mutators -
+
+#pragma mark Private
+
+char* MonotonicArena::AllocateBlock(const std::size_t theSize) {
+
+  char* block = static_cast<char*>(std::malloc(theSize));
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  blocks.append(block);
+
+  return block;
+}
+
+#pragma mark Public
+
+void* MonotonicArena::Allocate(const std::size_t theSize, const std::size_t theAlignment) {
+
+  Q_ASSERT(theAlignment > 0 && (theAlignment & (theAlignment - 1)) == 0);
+
+  allocationCount++;
+  bytesAllocated += static_cast<qint64>(theSize);
+
+  // oversized requests get a dedicated block so they don't waste the rest of the current one
+  if (theSize > blockSize / 4) {
+    return AllocateBlock(theSize);
+  }
+
+  std::size_t padding = (theAlignment - (reinterpret_cast<std::uintptr_t>(curr) & (theAlignment - 1))) & (theAlignment - 1);
+
+  if (curr == nullptr || static_cast<std::size_t>(end - curr) < padding + theSize) {
+    curr = AllocateBlock(blockSize);
+    end = curr + blockSize;
+    padding = 0;
+  }
+
+  void* allocation = curr + padding;
+  curr += padding + theSize;
+
+  return allocation;
+}
+
+void MonotonicArena::Release() {
+
+  foreach (char* currBlock, blocks) {
+    std::free(currBlock);
+  }
+
+  blocks.clear();
+  curr = nullptr;
+  end = nullptr;
+
+  allocationCount = 0;
+  bytesAllocated = 0;
+}
+
+
+#pragma mark - Scope -
+
+MonotonicArena::Scope::Scope(MonotonicArena* theArena)
+: prevArena(currentArena) {
+
+  currentArena = theArena;
+}
+
+MonotonicArena::Scope::~Scope() {
+
+  currentArena = prevArena;
+}
+
+
+#pragma mark - ArenaAllocated -
+
+void* ArenaAllocated::operator new(std::size_t theSize) {
+
+  MonotonicArena* arena = currentArena;
+  char* allocation = nullptr;
+
+  if (arena != nullptr) {
+    allocation = static_cast<char*>(arena->Allocate(ALLOCATION_HEADER_SIZE + theSize));
+  }
+  else {
+    allocation = static_cast<char*>(std::malloc(ALLOCATION_HEADER_SIZE + theSize));
+    if (allocation == nullptr) {
+      throw std::bad_alloc();
+    }
+  }
+
+  *reinterpret_cast<MonotonicArena**>(allocation) = arena;
+
+  return allocation + ALLOCATION_HEADER_SIZE;
+}
+
+void ArenaAllocated::operator delete(void* thePtr) {
+
+  if (thePtr == nullptr) {
+    return;
+  }
+
+  // arena memory is reclaimed with the arena itself
+  if (ArenaOf(thePtr) == nullptr) {
+    std::free(static_cast<char*>(thePtr) - ALLOCATION_HEADER_SIZE);
+  }
+}
+
+MonotonicArena* ArenaAllocated::ArenaOf(const void* theObject) {
+
+  return *reinterpret_cast<MonotonicArena* const*>(static_cast<const char*>(theObject) - ALLOCATION_HEADER_SIZE);
+}
@@ -0,0 +1,108 @@
+//
+//  MonotonicArena.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef MonotonicArena_hpp
+#define MonotonicArena_hpp
+
+#include <QtGlobal>
+#include <QVector>
+
+#include <cstddef>
+
+// bump-pointer allocator. Memory is carved out of large blocks and only returned all at once, when the
+// arena is released or destroyed.
+class MonotonicArena {
+
+private:
+
+  static const std::size_t DEFAULT_BLOCK_SIZE;
+
+  std::size_t blockSize;
+
+  QVector<char*> blocks;
+  char* curr = nullptr;
+  char* end = nullptr;
+
+  int allocationCount = 0;
+  qint64 bytesAllocated = 0;
+
+  Q_DISABLE_COPY(MonotonicArena)
+
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+public:
+
+  explicit MonotonicArena(const std::size_t theBlockSize = DEFAULT_BLOCK_SIZE);
+  ~MonotonicArena();
+
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+public:
+
+  int BlockCount() const { return blocks.count(); }
+  int AllocationCount() const { return allocationCount; }
+  qint64 BytesAllocated() const { return bytesAllocated; }
+
+  // arena used by ArenaAllocated objects created on the calling thread, nullptr for the regular heap
+  static MonotonicArena* Current();
+
+
+#pragma mark - Mutators -
+
+#pragma mark Private
+private:
+
+  char* AllocateBlock(const std::size_t theSize);
+
+#pragma mark Public
+public:
+
+  void* Allocate(const std::size_t theSize, const std::size_t theAlignment = alignof(std::max_align_t));
+  void Release();
+
+
+#pragma mark - Scope -
+
+public:
+
+  // makes an arena current for the calling thread until the scope ends
+  class Scope {
+
+  private:
+
+    MonotonicArena* prevArena;
+
+    Q_DISABLE_COPY(Scope)
+
+  public:
+
+    explicit Scope(MonotonicArena* theArena);
+    ~Scope();
+  };
+
+};
+
+// base for classes whose instances are placed in the current MonotonicArena (if any) when created with new.
+// delete still runs destructors as usual, but memory owned by an arena is only reclaimed with the arena.
+class ArenaAllocated {
+
+public:
+
+  static void* operator new(std::size_t theSize);
+  static void operator delete(void* thePtr);
+
+  // arena the object was allocated from, theObject must be the pointer returned by new
+  static MonotonicArena* ArenaOf(const void* theObject);
+
+};
+
+#endif /* MonotonicArena_hpp */
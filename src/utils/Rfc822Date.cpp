@@ -0,0 +1,253 @@
+//
+//  Rfc822Date.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "utils/Rfc822Date.hpp"
+
+#include <cstring>
+
+static const char DAY_NAMES[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+static const char MONTH_NAMES[12][4] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+static const qint64 SECS_PER_DAY = 86400;
+
+static inline bool IsSpace(const char theChar) {
+
+  return theChar == ' ' || theChar == '\t' || theChar == '\n' || theChar == '\r';
+}
+
+static inline char ToLower(const char theChar) {
+
+  return (theChar >= 'A' && theChar <= 'Z') ? static_cast<char>(theChar - 'A' + 'a') : theChar;
+}
+
+static void SkipSpaces(const char*& theCurr, const char* theEnd) {
+
+  while (theCurr < theEnd && IsSpace(*theCurr)) {
+    theCurr++;
+  }
+}
+
+static bool ReadNumber(const char*& theCurr, const char* theEnd, const int theMinDigits, const int theMaxDigits, int& theValue) {
+
+  int digitCount = 0;
+  theValue = 0;
+
+  while (theCurr < theEnd && digitCount < theMaxDigits && *theCurr >= '0' && *theCurr <= '9') {
+    theValue = theValue * 10 + (*theCurr - '0');
+    theCurr++;
+    digitCount++;
+  }
+
+  return digitCount >= theMinDigits;
+}
+
+static bool MatchesIgnoringCase(const char* theCurr, const char* theEnd, const char* theLiteral, const int theLiteralSize) {
+
+  if (theEnd - theCurr < theLiteralSize) {
+    return false;
+  }
+
+  for (int index = 0; index < theLiteralSize; index++) {
+    if (ToLower(theCurr[index]) != ToLower(theLiteral[index])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// days since 1970-01-01 in the proleptic gregorian calendar (H. Hinnant's days_from_civil)
+static qint64 DaysFromCivil(qint64 theYear, const int theMonth, const int theDay) {
+
+  theYear -= (theMonth <= 2) ? 1 : 0;
+
+  const qint64 era = (theYear >= 0 ? theYear : theYear - 399) / 400;
+  const qint64 yearOfEra = theYear - era * 400;
+  const qint64 dayOfYear = (153 * (theMonth > 2 ? theMonth - 3 : theMonth + 9) + 2) / 5 + theDay - 1;
+  const qint64 dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+  return era * 146097 + dayOfEra - 719468;
+}
+
+static void CivilFromDays(qint64 theDays, qint64& theYear, int& theMonth, int& theDay) {
+
+  theDays += 719468;
+
+  const qint64 era = (theDays >= 0 ? theDays : theDays - 146096) / 146097;
+  const qint64 dayOfEra = theDays - era * 146097;
+  const qint64 yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+  const qint64 dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  const qint64 shiftedMonth = (5 * dayOfYear + 2) / 153;
+
+  theDay = static_cast<int>(dayOfYear - (153 * shiftedMonth + 2) / 5 + 1);
+  theMonth = static_cast<int>(shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9);
+  theYear = yearOfEra + era * 400 + ((theMonth <= 2) ? 1 : 0);
+}
+
+static int DaysInMonth(const int theYear, const int theMonth) {
+
+  static const int DAYS_IN_MONTH[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+  const bool isLeapYear = (theYear % 4 == 0 && theYear % 100 != 0) || theYear % 400 == 0;
+
+  return (theMonth == 2 && isLeapYear) ? 29 : DAYS_IN_MONTH[theMonth - 1];
+}
+
+static inline void WriteTwoDigits(char* theBuffer, const int theValue) {
+
+  theBuffer[0] = static_cast<char>('0' + theValue / 10);
+  theBuffer[1] = static_cast<char>('0' + theValue % 10);
+}
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+
+qint64 Rfc822Date::ParseSecsSinceEpoch(const char* theData, const int theSize, bool* theOk) {
+
+  if (theOk != nullptr) {
+    *theOk = false;
+  }
+
+  if (theData == nullptr) {
+    return 0;
+  }
+
+  const char* curr = theData;
+  const char* end = theData + theSize;
+
+  SkipSpaces(curr, end);
+
+  // the day name is redundant, so it is skipped rather than validated
+  if (end - curr >= 4 && curr[3] == ',') {
+    curr += 4;
+    SkipSpaces(curr, end);
+  }
+
+  int day = 0;
+  if (!ReadNumber(curr, end, 1, 2, day)) {
+    return 0;
+  }
+  SkipSpaces(curr, end);
+
+  int month = 0;
+  for (int monthIndex = 0; monthIndex < 12 && month == 0; monthIndex++) {
+    if (MatchesIgnoringCase(curr, end, MONTH_NAMES[monthIndex], 3)) {
+      month = monthIndex + 1;
+    }
+  }
+  if (month == 0) {
+    return 0;
+  }
+  curr += 3;
+  SkipSpaces(curr, end);
+
+  int year = 0;
+  if (!ReadNumber(curr, end, 4, 4, year)) {
+    return 0;
+  }
+  SkipSpaces(curr, end);
+
+  int hours = 0;
+  int minutes = 0;
+  int seconds = 0;
+
+  if (!ReadNumber(curr, end, 2, 2, hours) || curr >= end || *curr++ != ':' || !ReadNumber(curr, end, 2, 2, minutes)) {
+    return 0;
+  }
+  if (curr < end && *curr == ':') {
+    curr++;
+    if (!ReadNumber(curr, end, 2, 2, seconds)) {
+      return 0;
+    }
+  }
+  SkipSpaces(curr, end);
+
+  int offsetSecs = 0;
+
+  if (curr < end && (*curr == '+' || *curr == '-')) {
+
+    const int sign = (*curr == '-') ? -1 : 1;
+    curr++;
+
+    int offset = 0;
+    if (!ReadNumber(curr, end, 4, 4, offset) || offset % 100 >= 60) {
+      return 0;
+    }
+
+    offsetSecs = sign * ((offset / 100) * 3600 + (offset % 100) * 60);
+  }
+  else if (MatchesIgnoringCase(curr, end, "UTC", 3) || MatchesIgnoringCase(curr, end, "GMT", 3)) {
+    curr += 3;
+  }
+  else if (MatchesIgnoringCase(curr, end, "UT", 2)) {
+    curr += 2;
+  }
+  else if (curr < end && (*curr == 'Z' || *curr == 'z')) {
+    curr++;
+  }
+  else {
+    return 0;
+  }
+
+  SkipSpaces(curr, end);
+
+  if (curr != end || day < 1 || day > DaysInMonth(year, month) || hours > 23 || minutes > 59 || seconds > 60) {
+    return 0;
+  }
+
+  if (theOk != nullptr) {
+    *theOk = true;
+  }
+
+  return DaysFromCivil(year, month, day) * SECS_PER_DAY + hours * 3600 + minutes * 60 + seconds - offsetSecs;
+}
+
+int Rfc822Date::FormatSecsSinceEpoch(const qint64 theSecsSinceEpoch, char* theBuffer) {
+
+  qint64 days = theSecsSinceEpoch / SECS_PER_DAY;
+  qint64 secsOfDay = theSecsSinceEpoch % SECS_PER_DAY;
+
+  if (secsOfDay < 0) {
+    secsOfDay += SECS_PER_DAY;
+    days--;
+  }
+
+  qint64 year = 0;
+  int month = 0;
+  int day = 0;
+  CivilFromDays(days, year, month, day);
+
+  if (year < 0 || year > 9999) {
+    return 0;
+  }
+
+  // 1970-01-01 was a thursday
+  const int weekDay = static_cast<int>(((days % 7) + 7 + 4) % 7);
+
+  char* curr = theBuffer;
+
+  memcpy(curr, DAY_NAMES[weekDay], 3);
+  curr[3] = ',';
+  curr[4] = ' ';
+  WriteTwoDigits(curr + 5, day);
+  curr[7] = ' ';
+  memcpy(curr + 8, MONTH_NAMES[month - 1], 3);
+  curr[11] = ' ';
+  WriteTwoDigits(curr + 12, static_cast<int>(year / 100));
+  WriteTwoDigits(curr + 14, static_cast<int>(year % 100));
+  curr[16] = ' ';
+  WriteTwoDigits(curr + 17, static_cast<int>(secsOfDay / 3600));
+  curr[19] = ':';
+  WriteTwoDigits(curr + 20, static_cast<int>((secsOfDay / 60) % 60));
+  curr[22] = ':';
+  WriteTwoDigits(curr + 23, static_cast<int>(secsOfDay % 60));
+  memcpy(curr + 25, " +0000", 6);
+
+  return FORMATTED_SIZE;
+}
@@ -0,0 +1,37 @@
+//
+//  Rfc822Date.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef Rfc822Date_hpp
+#define Rfc822Date_hpp
+
+#include <QtGlobal>
+
+// locale independent codec for the rfc 822 dates used by <pubDate> ("Mon, 02 Mar 2020 10:00:00 +0000").
+// Dates are always formatted in utc.
+class Rfc822Date {
+
+public:
+
+  // formatted dates are always exactly this long (no null terminator is written)
+  static const int FORMATTED_SIZE = 31;
+
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+public:
+
+  // accepts an optional day name, 1-2 digit days, optional seconds and +hhmm/-hhmm/GMT/UT/UTC/Z zones
+  static qint64 ParseSecsSinceEpoch(const char* theData, const int theSize, bool* theOk = nullptr);
+
+  // writes FORMATTED_SIZE bytes to theBuffer, returns 0 (and writes nothing) for years outside 0-9999
+  static int FormatSecsSinceEpoch(const qint64 theSecsSinceEpoch, char* theBuffer);
+
+};
+
+#endif /* Rfc822Date_hpp */
@@ -0,0 +1,235 @@
+//
+//  SaveTransaction.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "utils/SaveTransaction.hpp"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int SyncFileDescriptor(const int theFd) {
+
+#ifdef F_FULLFSYNC
+  // fsync() on macOS doesn't flush the drive's write cache
+  if (fcntl(theFd, F_FULLFSYNC) == 0) {
+    return 0;
+  }
+#endif
+
+  return fsync(theFd);
+}
+
+static mode_t DefaultNewFileMode() {
+
+  const mode_t processUmask = umask(0);
+  umask(processUmask);
+
+  return 0644 & ~processUmask;
+}
+
+// the umask can only be read by briefly replacing it, which would race with other threads creating files. It is
+// read once during static initialization, before main() starts any thread
+static const mode_t NEW_FILE_MODE = DefaultNewFileMode();
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+
+SaveTransaction::SaveTransaction() {
+
+}
+
+SaveTransaction::~SaveTransaction() {
+
+  if (!committed) {
+    RemoveTempFiles();
+  }
+}
+
+
+#pragma mark - Mutators -
+
+#pragma mark Private
+
+bool SaveTransaction::WriteTempFile(PendingFile& theFile, const qint64 theModifiedTime, const int theFileMode) {
+
+  const QFileInfo fileInfo(theFile.path);
+  QByteArray tempPathTemplate = QString("%1/.%2.XXXXXX").arg(fileInfo.absolutePath(), fileInfo.fileName()).toLocal8Bit();
+
+  const int fd = mkstemp(tempPathTemplate.data());
+  if (fd < 0) {
+    qWarning().noquote().nospace() << "error creating temporary file for '" << theFile.path << "': " << strerror(errno);
+    return false;
+  }
+
+  theFile.tempPath = QString::fromLocal8Bit(tempPathTemplate);
+
+  // mkstemp() creates files as 0600 - use the pinned mode, or keep the existing file's mode, otherwise use the
+  // default for new files
+  struct stat existingStat;
+  mode_t fileMode = NEW_FILE_MODE;
+
+  if (theFileMode >= 0) {
+    fileMode = static_cast<mode_t>(theFileMode & 07777);
+  }
+  else if (stat(QFile::encodeName(theFile.path).constData(), &existingStat) == 0) {
+    fileMode = existingStat.st_mode & 07777;
+  }
+
+  bool success = (fchmod(fd, fileMode) == 0);
+
+  const char* curr = theFile.data.constData();
+  qint64 remaining = theFile.data.size();
+
+  // the whole buffer is handed to the kernel in as few write() calls as possible
+  while (success && remaining > 0) {
+
+    const ssize_t written = write(fd, curr, static_cast<size_t>(remaining));
+
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      success = false;
+      break;
+    }
+
+    curr += written;
+    remaining -= written;
+  }
+
+  if (success && theModifiedTime >= 0) {
+
+    struct timespec fileTimes[2];
+    fileTimes[0].tv_sec = static_cast<time_t>(theModifiedTime / 1000);
+    fileTimes[0].tv_nsec = static_cast<long>((theModifiedTime % 1000) * 1000000);
+    fileTimes[1] = fileTimes[0];
+
+    success = (futimens(fd, fileTimes) == 0);
+  }
+
+  if (success && SyncFileDescriptor(fd) != 0) {
+    success = false;
+  }
+
+  if (!success) {
+    qWarning().noquote().nospace() << "error writing temporary file for '" << theFile.path << "': " << strerror(errno);
+  }
+
+  if (close(fd) != 0 && success) {
+    qWarning().noquote().nospace() << "error closing temporary file for '" << theFile.path << "': " << strerror(errno);
+    success = false;
+  }
+
+  return success;
+}
+
+bool SaveTransaction::SyncDirectory(const QString& theDirPath) {
+
+  const int fd = open(QFile::encodeName(theDirPath).constData(), O_RDONLY);
+  if (fd < 0) {
+    qWarning().noquote().nospace() << "error opening directory for sync '" << theDirPath << "': " << strerror(errno);
+    return false;
+  }
+
+  const bool success = (SyncFileDescriptor(fd) == 0);
+  if (!success) {
+    qWarning().noquote().nospace() << "error syncing directory '" << theDirPath << "': " << strerror(errno);
+  }
+
+  close(fd);
+
+  return success;
+}
+
+void SaveTransaction::RemoveTempFiles() {
+
+  for (int index = 0; index < files.count(); index++) {
+
+    if (!files.at(index).tempPath.isEmpty()) {
+      unlink(QFile::encodeName(files.at(index).tempPath).constData());
+      files[index].tempPath.clear();
+    }
+  }
+}
+
+#pragma mark Public
+
+void SaveTransaction::AddFile(const QString& thePath, const QByteArray& theData) {
+
+  Q_ASSERT(!committed);
+
+  PendingFile pendingFile;
+  pendingFile.path = thePath;
+  pendingFile.data = theData;
+
+  files.append(pendingFile);
+}
+
+void SaveTransaction::SetModifiedTime(const qint64 theMSecsSinceEpoch) {
+
+  modifiedTime = theMSecsSinceEpoch;
+}
+
+void SaveTransaction::SetFileMode(const int theFileMode) {
+
+  fileMode = theFileMode;
+}
+
+bool SaveTransaction::Commit() {
+
+  if (committed) {
+    return true;
+  }
+
+  // 1. write + sync every output before publishing any of them
+  for (int index = 0; index < files.count(); index++) {
+
+    if (!WriteTempFile(files[index], modifiedTime, fileMode)) {
+      RemoveTempFiles();
+      return false;
+    }
+  }
+
+  // 2. publish
+  QSet<QString> dirPaths;
+
+  for (int index = 0; index < files.count(); index++) {
+
+    PendingFile& currFile = files[index];
+
+    if (rename(QFile::encodeName(currFile.tempPath).constData(), QFile::encodeName(currFile.path).constData()) != 0) {
+      qWarning().noquote().nospace() << "error publishing '" << currFile.path << "': " << strerror(errno);
+      RemoveTempFiles();
+      return false;
+    }
+
+    currFile.tempPath.clear();
+    dirPaths.insert(QFileInfo(currFile.path).absolutePath());
+  }
+
+  committed = true;
+
+  // 3. make the renames themselves durable
+  bool success = true;
+
+  foreach (const QString& currDirPath, dirPaths) {
+    success = SyncDirectory(currDirPath) && success;
+  }
+
+  return success;
+}
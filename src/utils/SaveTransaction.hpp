@@ -0,0 +1,82 @@
+//
+//  SaveTransaction.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef SaveTransaction_hpp
+#define SaveTransaction_hpp
+
+#include <QObject>
+#include <QList>
+
+// publishes one or more fully buffered files atomically. Every file is first written to a temporary file in
+// its destination directory and synced - only once all of them are durable are they renamed into place (in
+// the order they were added) and their directories synced. A failure before the renames leaves the previous
+// outputs untouched.
+class SaveTransaction {
+
+private:
+
+  struct PendingFile {
+    QString path;
+    QByteArray data;
+    QString tempPath;
+  };
+
+  QList<PendingFile> files;
+  qint64 modifiedTime = -1;
+  int fileMode = -1;
+
+  bool committed = false;
+
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+public:
+
+  SaveTransaction();
+  ~SaveTransaction();
+
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+public:
+
+  int Count() const { return files.count(); }
+  const QString& FilePath(const int theIndex) const { return files.at(theIndex).path; }
+  const QByteArray& FileData(const int theIndex) const { return files.at(theIndex).data; }
+  bool Committed() const { return committed; }
+
+
+#pragma mark - Mutators -
+
+#pragma mark Private
+private:
+
+  static bool WriteTempFile(PendingFile& theFile, const qint64 theModifiedTime, const int theFileMode);
+  static bool SyncDirectory(const QString& theDirPath);
+
+  void RemoveTempFiles();
+
+#pragma mark Public
+public:
+
+  void AddFile(const QString& thePath, const QByteArray& theData);
+
+  // pins the modification time (msecs since epoch) of every published file, e.g. so sidecars can reference it
+  void SetModifiedTime(const qint64 theMSecsSinceEpoch);
+
+  // pins the permissions of every published file (e.g. 0600 for private files), -1 keeps an existing file's
+  // mode and uses the umask default for new files
+  void SetFileMode(const int theFileMode);
+
+  bool Commit();
+
+};
+
+#endif /* SaveTransaction_hpp */
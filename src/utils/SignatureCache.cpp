@@ -0,0 +1,217 @@
+//
+//  SignatureCache.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "utils/SignatureCache.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utils/SaveTransaction.hpp"
+
+static const int ENTRY_VERSION = 1;
+static const qint64 MAX_ENTRY_SIZE = 64 * 1024;
+
+// a file modified this close to (or after) its entry being written could change again without its mtime
+// moving, its entry is only trusted after comparing the content hash
+static const qint64 RACY_WINDOW_NS = Q_INT64_C(2000000000);
+
+static QString& CacheDirStorage() {
+
+  static QString cacheDir = SignatureCache::DefaultCacheDir();
+
+  return cacheDir;
+}
+
+static qint64 TimespecNs(const struct timespec& theTime) {
+
+  return static_cast<qint64>(theTime.tv_sec) * 1000000000 + theTime.tv_nsec;
+}
+
+// only entries (and dirs) nobody else can write or read are used
+static bool IsPrivate(const struct stat& theStat) {
+
+  return theStat.st_uid == geteuid() && (theStat.st_mode & 077) == 0;
+}
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+
+QString SignatureCache::EntryPath(const FileIdentity& theIdentity, const QByteArray& theKeyFingerprint, const EnclosureSignatureType theSignatureType) {
+
+  QCryptographicHash entryHash(QCryptographicHash::Sha256);
+  entryHash.addData(QByteArray::number(theIdentity.device) + ':' + QByteArray::number(theIdentity.inode) + ':');
+  entryHash.addData(QByteArray::number(static_cast<int>(theSignatureType)) + ':' + theKeyFingerprint);
+
+  return QString("%1/%2.json").arg(CacheDir(), QString::fromLatin1(entryHash.result().toHex()));
+}
+
+bool SignatureCache::EnsureCacheDir() {
+
+  const QString cacheDir = CacheDir();
+  const QByteArray encodedCacheDir = QFile::encodeName(cacheDir);
+
+  if (!QDir().mkpath(cacheDir) || chmod(encodedCacheDir.constData(), 0700) != 0) {
+    qWarning().noquote().nospace() << "error preparing signature cache dir '" << cacheDir << "': " << strerror(errno);
+    return false;
+  }
+
+  struct stat dirStat;
+  if (lstat(encodedCacheDir.constData(), &dirStat) != 0 || !S_ISDIR(dirStat.st_mode) || !IsPrivate(dirStat)) {
+    qWarning().noquote().nospace() << "ignoring signature cache dir '" << cacheDir << "' - it isn't a private dir owned by the current user";
+    return false;
+  }
+
+  return true;
+}
+
+#pragma mark Public
+
+QString SignatureCache::DefaultCacheDir() {
+
+  return QString("%1/sparkless/signatures").arg(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation));
+}
+
+QString SignatureCache::CacheDir() {
+
+  return CacheDirStorage();
+}
+
+SignatureCache::FileIdentity SignatureCache::IdentityForPath(const QString& theFilePath) {
+
+  FileIdentity identity;
+
+  struct stat fileStat;
+  if (stat(QFile::encodeName(theFilePath).constData(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+    return identity;
+  }
+
+  identity.device = static_cast<qint64>(fileStat.st_dev);
+  identity.inode = static_cast<qint64>(fileStat.st_ino);
+  identity.size = static_cast<qint64>(fileStat.st_size);
+
+#ifdef Q_OS_DARWIN
+  identity.modifiedTimeNs = TimespecNs(fileStat.st_mtimespec);
+  identity.changedTimeNs = TimespecNs(fileStat.st_ctimespec);
+#else
+  identity.modifiedTimeNs = TimespecNs(fileStat.st_mtim);
+  identity.changedTimeNs = TimespecNs(fileStat.st_ctim);
+#endif
+
+  return identity;
+}
+
+QByteArray SignatureCache::Lookup(const FileIdentity& theIdentity, const QByteArray& theKeyFingerprint, const EnclosureSignatureType theSignatureType, const QByteArray& theSha256) {
+
+  if (!Enabled() || !theIdentity.IsValid()) {
+    return QByteArray();
+  }
+
+  const int fd = open(QFile::encodeName(EntryPath(theIdentity, theKeyFingerprint, theSignatureType)).constData(), O_RDONLY | O_NOFOLLOW);
+  if (fd < 0) {
+    return QByteArray();
+  }
+
+  QByteArray entryJson;
+
+  struct stat entryStat;
+  if (fstat(fd, &entryStat) == 0 && S_ISREG(entryStat.st_mode) && IsPrivate(entryStat) && entryStat.st_size <= MAX_ENTRY_SIZE) {
+
+    entryJson.resize(static_cast<int>(entryStat.st_size));
+
+    const ssize_t readSize = read(fd, entryJson.data(), static_cast<size_t>(entryJson.size()));
+    entryJson.resize(readSize > 0 ? static_cast<int>(readSize) : 0);
+  }
+
+  close(fd);
+
+  const QJsonObject entry = QJsonDocument::fromJson(entryJson).object();
+
+  // the entry name is only a hash, everything it stands for is compared again
+  if (entry.value("version").toInt() != ENTRY_VERSION
+      || entry.value("keyFingerprint").toString().toLatin1() != theKeyFingerprint
+      || entry.value("signatureType").toInt() != static_cast<int>(theSignatureType)
+      || entry.value("device").toString().toLongLong() != theIdentity.device
+      || entry.value("inode").toString().toLongLong() != theIdentity.inode
+      || entry.value("size").toString().toLongLong() != theIdentity.size) {
+    return QByteArray();
+  }
+
+  const QByteArray signature = entry.value("signature").toString().toLatin1();
+
+  // the content decides once it is known, whatever the stat fields say
+  if (!theSha256.isEmpty()) {
+    return (entry.value("sha256").toString().toLatin1() == theSha256.toHex()) ? signature : QByteArray();
+  }
+
+  const qint64 modifiedTimeNs = entry.value("modifiedTimeNs").toString().toLongLong();
+  const qint64 changedTimeNs = entry.value("changedTimeNs").toString().toLongLong();
+  const qint64 storedTimeNs = entry.value("storedTimeNs").toString().toLongLong();
+
+  if (modifiedTimeNs != theIdentity.modifiedTimeNs || changedTimeNs != theIdentity.changedTimeNs) {
+    return QByteArray();
+  }
+  if (storedTimeNs - qMax(modifiedTimeNs, changedTimeNs) < RACY_WINDOW_NS) {
+    return QByteArray();
+  }
+
+  return signature;
+}
+
+
+#pragma mark - Mutators -
+
+#pragma mark Public
+
+void SignatureCache::SetCacheDir(const QString& theCacheDir) {
+
+  CacheDirStorage() = theCacheDir;
+}
+
+bool SignatureCache::Store(const FileIdentity& theIdentity, const QByteArray& theKeyFingerprint, const EnclosureSignatureType theSignatureType, const QByteArray& theSha256, const QByteArray& theSignature) {
+
+  if (!Enabled() || !theIdentity.IsValid() || theSha256.isEmpty() || theSignature.isEmpty()) {
+    return false;
+  }
+
+  if (!EnsureCacheDir()) {
+    return false;
+  }
+
+  // 64 bit values are stored as strings, json numbers are doubles
+  QJsonObject entry;
+  entry.insert("version", ENTRY_VERSION);
+  entry.insert("keyFingerprint", QString::fromLatin1(theKeyFingerprint));
+  entry.insert("signatureType", static_cast<int>(theSignatureType));
+  entry.insert("device", QString::number(theIdentity.device));
+  entry.insert("inode", QString::number(theIdentity.inode));
+  entry.insert("size", QString::number(theIdentity.size));
+  entry.insert("modifiedTimeNs", QString::number(theIdentity.modifiedTimeNs));
+  entry.insert("changedTimeNs", QString::number(theIdentity.changedTimeNs));
+  entry.insert("storedTimeNs", QString::number(QDateTime::currentMSecsSinceEpoch() * 1000000));
+  entry.insert("sha256", QString::fromLatin1(theSha256.toHex()));
+  entry.insert("signature", QString::fromLatin1(theSignature));
+
+  SaveTransaction saveTransaction;
+  saveTransaction.SetFileMode(0600);
+  saveTransaction.AddFile(EntryPath(theIdentity, theKeyFingerprint, theSignatureType), QJsonDocument(entry).toJson(QJsonDocument::Compact));
+
+  return saveTransaction.Commit();
+}
@@ -0,0 +1,85 @@
+//
+//  SignatureCache.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef SignatureCache_hpp
+#define SignatureCache_hpp
+
+#include <QObject>
+
+#include "Constants.hpp"
+
+// process-wide, on-disk cache of the signatures made by EdDsaSignatureGenerator and DsaSignatureGenerator, so
+// re-running `sign` or `add` on unchanged bundles skips the crypto work. Entries are keyed by the file's
+// identity (device, inode), the key's fingerprint and the signature type, and store the file's size, mtime,
+// ctime and sha256. A signature is reused without reading the file only while every stat field still
+// matches and the file's mtime was safely in the past when the entry was written - otherwise the caller has
+// to hash the file, and the signature is only reused if the sha256 still matches.
+//
+// The cache dir is created 0700 and entries are written atomically as 0600 files. Dirs or entries that are
+// group/world accessible or owned by someone else are ignored.
+class SignatureCache {
+
+public:
+
+  struct FileIdentity {
+    qint64 device = -1;
+    qint64 inode = -1;
+    qint64 size = -1;
+    qint64 modifiedTimeNs = -1;
+    qint64 changedTimeNs = -1;
+
+    bool IsValid() const { return inode >= 0; }
+
+    bool operator==(const FileIdentity& theOther) const {
+      return device == theOther.device && inode == theOther.inode && size == theOther.size
+          && modifiedTimeNs == theOther.modifiedTimeNs && changedTimeNs == theOther.changedTimeNs;
+    }
+    bool operator!=(const FileIdentity& theOther) const { return !(*this == theOther); }
+  };
+
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+private:
+
+  static QString EntryPath(const FileIdentity&, const QByteArray& theKeyFingerprint, const EnclosureSignatureType);
+  static bool EnsureCacheDir();
+
+#pragma mark Public
+public:
+
+  // <user cache dir>/sparkless/signatures
+  static QString DefaultCacheDir();
+
+  // empty when the cache is disabled
+  static QString CacheDir();
+  static bool Enabled() { return !CacheDir().isEmpty(); }
+
+  // stat()s the file, the identity is invalid if it doesn't exist
+  static FileIdentity IdentityForPath(const QString& theFilePath);
+
+  // the cached signature, or an empty one. Without theSha256 (raw) only the stat fields are compared
+  static QByteArray Lookup(const FileIdentity&, const QByteArray& theKeyFingerprint, const EnclosureSignatureType, const QByteArray& theSha256 = QByteArray());
+
+
+#pragma mark - Mutators -
+
+#pragma mark Public
+public:
+
+  // must be called before any signing starts, an empty path disables the cache
+  static void SetCacheDir(const QString& theCacheDir);
+
+  // theIdentity must be taken before the file was hashed/signed, and callers only store once IdentityForPath()
+  // still returns the same identity afterwards - otherwise the signature may belong to other content
+  static bool Store(const FileIdentity&, const QByteArray& theKeyFingerprint, const EnclosureSignatureType, const QByteArray& theSha256, const QByteArray& theSignature);
+
+};
+
+#endif /* SignatureCache_hpp */
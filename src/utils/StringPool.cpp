@@ -0,0 +1,64 @@
+//
+//  StringPool.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "utils/StringPool.hpp"
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+
+StringPool::StringPool() {
+
+}
+
+
+#pragma mark - Mutators -
+
+#pragma mark Public
+
+QString StringPool::Intern(const QString& theString) {
+
+  if (theString.isEmpty()) {
+    return theString;
+  }
+
+  QSet<QString>::const_iterator stringIter = strings.constFind(theString);
+
+  if (stringIter == strings.constEnd()) {
+    stringIter = strings.insert(theString);
+  }
+
+  return *stringIter;
+}
+
+QStringList StringPool::InternList(const QString& theJoinedList, const QChar theSeparator) {
+
+  if (theJoinedList.isEmpty()) {
+    return QStringList();
+  }
+
+  QHash<QString, QStringList>::const_iterator listIter = stringLists.constFind(theJoinedList);
+
+  if (listIter == stringLists.constEnd()) {
+
+    QStringList internedList;
+    foreach (const QString& currString, theJoinedList.split(theSeparator)) {
+      internedList.append(Intern(currString));
+    }
+
+    listIter = stringLists.insert(Intern(theJoinedList), internedList);
+  }
+
+  return listIter.value();
+}
+
+void StringPool::Clear() {
+
+  strings.clear();
+  stringLists.clear();
+}
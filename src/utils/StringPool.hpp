@@ -0,0 +1,54 @@
+//
+//  StringPool.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef StringPool_hpp
+#define StringPool_hpp
+
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+// interning table for the handful of values repeated by nearly every enclosure (mime types, versions,
+// installer arguments, ...). Equal values returned by the pool share a single implicitly shared buffer.
+class StringPool {
+
+private:
+
+  QSet<QString> strings;
+  QHash<QString, QStringList> stringLists;
+
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+public:
+
+  StringPool();
+
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+public:
+
+  int Count() const { return strings.count() + stringLists.count(); }
+
+
+#pragma mark - Mutators -
+
+#pragma mark Public
+public:
+
+  QString Intern(const QString&);
+  QStringList InternList(const QString& theJoinedList, const QChar theSeparator = ' ');
+
+  void Clear();
+
+};
+
+#endif /* StringPool_hpp */
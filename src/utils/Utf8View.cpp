@@ -0,0 +1,134 @@
+//
+//  Utf8View.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "utils/Utf8View.hpp"
+
+#include <cstring>
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+
+bool Utf8View::Equals(const char* theLiteral, const int theLiteralSize) const {
+
+  return size == theLiteralSize && (size == 0 || memcmp(data, theLiteral, size) == 0);
+}
+
+qlonglong Utf8View::ToLongLong(bool* theOk) const {
+
+  qlonglong value = 0;
+  bool negative = false;
+  int index = 0;
+
+  while (index < size && (data[index] == ' ' || data[index] == '\t' || data[index] == '\n' || data[index] == '\r')) {
+    index++;
+  }
+
+  if (index < size && (data[index] == '-' || data[index] == '+')) {
+    negative = (data[index] == '-');
+    index++;
+  }
+
+  const int digitsBegin = index;
+
+  while (index < size && data[index] >= '0' && data[index] <= '9') {
+    value = (value * 10) + (data[index] - '0');
+    index++;
+  }
+
+  const bool ok = (index > digitsBegin && index == size);
+
+  if (theOk != nullptr) {
+    *theOk = ok;
+  }
+
+  // match QString::toLongLong() - invalid input yields 0
+  if (!ok) {
+    return 0;
+  }
+
+  return negative ? -value : value;
+}
+
+QByteArray Utf8View::ToByteArray() const {
+
+  if (data == nullptr) {
+    return QByteArray();
+  }
+
+  const char* ampersand = static_cast<const char*>(memchr(data, '&', size));
+
+  // fast path - nothing to unescape
+  if (ampersand == nullptr) {
+    return QByteArray(data, size);
+  }
+
+  QByteArray unescaped;
+  unescaped.reserve(size);
+
+  const char* curr = data;
+  const char* end = data + size;
+
+  while (curr < end) {
+
+    if (*curr != '&') {
+      unescaped.append(*curr);
+      curr++;
+      continue;
+    }
+
+    const char* semicolon = static_cast<const char*>(memchr(curr, ';', end - curr));
+    if (semicolon == nullptr) {
+      unescaped.append(curr, static_cast<int>(end - curr));
+      break;
+    }
+
+    const Utf8View entity(curr + 1, static_cast<int>(semicolon - curr - 1));
+
+    if (entity == "amp") { unescaped.append('&'); }
+    else if (entity == "lt") { unescaped.append('<'); }
+    else if (entity == "gt") { unescaped.append('>'); }
+    else if (entity == "quot") { unescaped.append('"'); }
+    else if (entity == "apos") { unescaped.append('\''); }
+    else if (entity.Size() > 1 && entity.Data()[0] == '#') {
+
+      bool ok = false;
+      const bool hex = (entity.Data()[1] == 'x' || entity.Data()[1] == 'X');
+      const QByteArray digits = QByteArray::fromRawData(entity.Data() + (hex ? 2 : 1), entity.Size() - (hex ? 2 : 1));
+      const uint codePoint = digits.toUInt(&ok, hex ? 16 : 10);
+
+      if (ok) {
+        unescaped.append(QString::fromUcs4(&codePoint, 1).toUtf8());
+      }
+      else {
+        unescaped.append(curr, static_cast<int>(semicolon - curr + 1));
+      }
+    }
+    else {
+      // unknown entity - keep as-is
+      unescaped.append(curr, static_cast<int>(semicolon - curr + 1));
+    }
+
+    curr = semicolon + 1;
+  }
+
+  return unescaped;
+}
+
+QString Utf8View::ToString() const {
+
+  if (data == nullptr) {
+    return QString();
+  }
+
+  if (memchr(data, '&', size) == nullptr) {
+    return QString::fromUtf8(data, size);
+  }
+
+  return QString::fromUtf8(ToByteArray());
+}
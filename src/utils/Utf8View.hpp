@@ -0,0 +1,55 @@
+//
+//  Utf8View.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef Utf8View_hpp
+#define Utf8View_hpp
+
+#include <QString>
+#include <QByteArray>
+
+// non-owning view into (possibly entity-escaped) utf-8 xml bytes. The viewed bytes must outlive the view.
+class Utf8View {
+
+private:
+
+  const char* data = nullptr;
+  int size = 0;
+
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+public:
+
+  Utf8View() {}
+  Utf8View(const char* theData, const int theSize) : data(theData), size(theSize) {}
+
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+public:
+
+  const char* Data() const { return data; }
+  int Size() const { return size; }
+
+  bool IsNull() const { return data == nullptr; }
+  bool IsEmpty() const { return size == 0; }
+
+  bool Equals(const char* theLiteral, const int theLiteralSize) const;
+  template <int N> bool operator==(const char (&theLiteral)[N]) const { return Equals(theLiteral, N - 1); }
+  template <int N> bool operator!=(const char (&theLiteral)[N]) const { return !Equals(theLiteral, N - 1); }
+
+  qlonglong ToLongLong(bool* theOk = nullptr) const;
+
+  QByteArray ToByteArray() const;
+  QString ToString() const;
+
+};
+
+#endif /* Utf8View_hpp */
@@ -0,0 +1,53 @@
+//
+//  XmlByteScanner.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "utils/XmlByteScanner.hpp"
+
+struct ByteClassTable {
+
+  quint8 classes[256];
+
+  ByteClassTable() {
+
+    for (int index = 0; index < 256; index++) {
+      classes[index] = 0;
+    }
+
+    classes[static_cast<quint8>('<')] = XmlByteScanner::LessThanClass;
+    classes[static_cast<quint8>('>')] = XmlByteScanner::GreaterThanClass;
+    classes[static_cast<quint8>('"')] = XmlByteScanner::QuoteClass;
+    classes[static_cast<quint8>('\'')] = XmlByteScanner::QuoteClass;
+    classes[static_cast<quint8>('=')] = XmlByteScanner::EqualsClass;
+    classes[static_cast<quint8>(' ')] = XmlByteScanner::WhitespaceClass;
+    classes[static_cast<quint8>('\t')] = XmlByteScanner::WhitespaceClass;
+    classes[static_cast<quint8>('\r')] = XmlByteScanner::WhitespaceClass;
+    classes[static_cast<quint8>('\n')] = XmlByteScanner::WhitespaceClass;
+  }
+};
+
+static const ByteClassTable BYTE_CLASS_TABLE;
+
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+
+const char* XmlByteScanner::FindFirst(const char* theBegin, const char* theEnd, const unsigned theClasses) {
+
+  Q_ASSERT(theBegin <= theEnd);
+
+  const quint8* classes = BYTE_CLASS_TABLE.classes;
+
+  for (const char* curr = theBegin; curr < theEnd; curr++) {
+    if ((classes[static_cast<quint8>(*curr)] & theClasses) != 0) {
+      return curr;
+    }
+  }
+
+  return theEnd;
+}
@@ -0,0 +1,38 @@
+//
+//  XmlByteScanner.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef XmlByteScanner_hpp
+#define XmlByteScanner_hpp
+
+#include <QtGlobal>
+
+// finds the first byte of a set of xml byte classes in a buffer using a 256 entry class table
+class XmlByteScanner {
+
+public:
+
+  enum ByteClass {
+    LessThanClass     = 1 << 0,   // <
+    GreaterThanClass  = 1 << 1,   // >
+    QuoteClass        = 1 << 2,   // " and '
+    EqualsClass       = 1 << 3,   // =
+    WhitespaceClass   = 1 << 4,   // space, tab, cr, lf
+  };
+
+
+#pragma mark - Accessors -
+
+#pragma mark Public
+public:
+
+  // returns theEnd if none of theEnd - theBegin bytes belongs to theClasses
+  static const char* FindFirst(const char* theBegin, const char* theEnd, const unsigned theClasses);
+
+};
+
+#endif /* XmlByteScanner_hpp */
@@ -0,0 +1,394 @@
+//
+//  XmlScanner.cpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#include "utils/XmlScanner.hpp"
+
+#include <cstring>
+
+#include "utils/XmlByteScanner.hpp"
+
+static inline bool IsXmlWhitespace(const char theChar) {
+
+  return theChar == ' ' || theChar == '\t' || theChar == '\n' || theChar == '\r';
+}
+
+#pragma mark - XmlTag -
+
+Utf8View XmlTag::Attribute(const char* theName) const {
+
+  const char* curr = attributes.Data();
+  const char* end = curr + attributes.Size();
+  const int nameSize = static_cast<int>(strlen(theName));
+
+  while (curr != nullptr && curr < end) {
+
+    // each attribute is located through its '=', the name being the token right before it
+    const char* equals = XmlByteScanner::FindFirst(curr, end, XmlByteScanner::EqualsClass);
+    if (equals == end) {
+      break;
+    }
+
+    while (curr < equals && IsXmlWhitespace(*curr)) {
+      curr++;
+    }
+
+    const char* attributeName = curr;
+    const char* attributeNameEnd = equals;
+    while (attributeNameEnd > attributeName && IsXmlWhitespace(*(attributeNameEnd - 1))) {
+      attributeNameEnd--;
+    }
+    const int attributeNameSize = static_cast<int>(attributeNameEnd - attributeName);
+
+    curr = equals + 1;
+    while (curr < end && IsXmlWhitespace(*curr)) {
+      curr++;
+    }
+    if (curr >= end || (*curr != '"' && *curr != '\'')) {
+      break;
+    }
+
+    const char quote = *curr++;
+    const char* value = curr;
+    const char* valueEnd = static_cast<const char*>(memchr(value, quote, end - value));
+    if (valueEnd == nullptr) {
+      break;
+    }
+
+    if (attributeNameSize == nameSize && memcmp(attributeName, theName, nameSize) == 0) {
+      return Utf8View(value, static_cast<int>(valueEnd - value));
+    }
+
+    curr = valueEnd + 1;
+  }
+
+  return Utf8View();
+}
+
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+
+XmlScanner::XmlScanner(const char* theData, const qint64 theSize)
+: data(theData), size(theSize) {
+
+}
+
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+
+bool XmlScanner::HasPrefix(const char* thePrefix, const int thePrefixSize) const {
+
+  return (size - position) >= thePrefixSize && memcmp(data + position, thePrefix, thePrefixSize) == 0;
+}
+
+
+#pragma mark - Mutators -
+
+#pragma mark Private
+
+bool XmlScanner::SkipPast(const char* theTerminator, const int theTerminatorSize) {
+
+  qint64 curr = position;
+
+  while (curr + theTerminatorSize <= size) {
+
+    const char* candidate = static_cast<const char*>(memchr(data + curr, theTerminator[0], size - curr));
+    if (candidate == nullptr) {
+      break;
+    }
+
+    curr = candidate - data;
+
+    if (curr + theTerminatorSize <= size && memcmp(candidate, theTerminator, theTerminatorSize) == 0) {
+      position = curr + theTerminatorSize;
+      return true;
+    }
+
+    curr++;
+  }
+
+  SetError(QString("unterminated markup at offset %1 (expected '%2')").arg(position).arg(QString::fromLatin1(theTerminator)));
+  return false;
+}
+
+bool XmlScanner::SkipMarkup() {
+
+  if (HasPrefix("<!--", 4)) {
+    return SkipPast("-->", 3);
+  }
+  if (HasPrefix("<![CDATA[", 9)) {
+    return SkipPast("]]>", 3);
+  }
+  if (HasPrefix("<?", 2)) {
+    return SkipPast("?>", 2);
+  }
+
+  // <!DOCTYPE ...> - internal subsets are not supported by appcasts
+  return SkipPast(">", 1);
+}
+
+bool XmlScanner::ReadTag(XmlTag& theTag) {
+
+  Q_ASSERT(data[position] == '<');
+
+  theTag = XmlTag();
+  theTag.begin = position;
+
+  qint64 curr = position + 1;
+
+  if (curr < size && data[curr] == '/') {
+    theTag.closing = true;
+    curr++;
+  }
+
+  const qint64 nameBegin = curr;
+  while (curr < size && !IsXmlWhitespace(data[curr]) && data[curr] != '/' && data[curr] != '>') {
+    curr++;
+  }
+  theTag.name = Utf8View(data + nameBegin, static_cast<int>(curr - nameBegin));
+
+  const qint64 attributesBegin = curr;
+
+  // only quotes and '>' matter for finding the end of the tag, the bytes in between cost one class table
+  // lookup each
+  while (curr < size) {
+
+    const char* match = XmlByteScanner::FindFirst(data + curr, data + size, XmlByteScanner::QuoteClass | XmlByteScanner::GreaterThanClass);
+    curr = match - data;
+
+    if (curr >= size || *match == '>') {
+      break;
+    }
+
+    const char* quoteEnd = static_cast<const char*>(memchr(match + 1, *match, size - curr - 1));
+    if (quoteEnd == nullptr) {
+      curr = size;
+      break;
+    }
+
+    curr = (quoteEnd - data) + 1;
+  }
+
+  if (curr >= size) {
+    SetError(QString("unterminated tag at offset %1").arg(position));
+    return false;
+  }
+
+  qint64 attributesEnd = curr;
+  if (attributesEnd > attributesBegin && data[attributesEnd - 1] == '/') {
+    theTag.selfClosing = true;
+    attributesEnd--;
+  }
+
+  theTag.attributes = Utf8View(data + attributesBegin, static_cast<int>(attributesEnd - attributesBegin));
+  theTag.end = curr + 1;
+
+  position = theTag.end;
+
+  return true;
+}
+
+void XmlScanner::SetError(const QString& theErrorString) {
+
+  if (errorString.isNull()) {
+    errorString = theErrorString;
+  }
+  position = size;
+}
+
+#pragma mark Public
+
+void XmlScanner::Seek(const qint64 thePosition) {
+
+  position = qBound<qint64>(0, thePosition, size);
+}
+
+bool XmlScanner::ReadNextTag(XmlTag& theTag) {
+
+  while (position < size) {
+
+    const char* tagStart = static_cast<const char*>(memchr(data + position, '<', size - position));
+    if (tagStart == nullptr) {
+      position = size;
+      return false;
+    }
+
+    position = tagStart - data;
+
+    if (position + 1 < size && (data[position + 1] == '!' || data[position + 1] == '?')) {
+      if (!SkipMarkup()) {
+        return false;
+      }
+      continue;
+    }
+
+    return ReadTag(theTag);
+  }
+
+  return false;
+}
+
+bool XmlScanner::ReadNextStartTag(XmlTag& theTag) {
+
+  if (!ReadNextTag(theTag)) {
+    return false;
+  }
+
+  return !theTag.closing;
+}
+
+bool XmlScanner::SkipElement(const XmlTag& theStartTag) {
+
+  if (theStartTag.closing || theStartTag.selfClosing) {
+    return true;
+  }
+
+  int depth = 1;
+  XmlTag currTag;
+
+  while (depth > 0 && ReadNextTag(currTag)) {
+
+    if (currTag.closing) {
+      depth--;
+    }
+    else if (!currTag.selfClosing) {
+      depth++;
+    }
+  }
+
+  return depth == 0;
+}
+
+bool XmlScanner::SkipUnnestedElement(const XmlTag& theStartTag) {
+
+  if (theStartTag.closing || theStartTag.selfClosing) {
+    return true;
+  }
+
+  const char* name = theStartTag.name.Data();
+  const int nameSize = theStartTag.name.Size();
+
+  while (position < size) {
+
+    const char* tagStart = static_cast<const char*>(memchr(data + position, '<', size - position));
+    if (tagStart == nullptr) {
+      break;
+    }
+
+    position = tagStart - data;
+
+    if (position + 1 < size && (data[position + 1] == '!' || data[position + 1] == '?')) {
+      if (!SkipMarkup()) {
+        return false;
+      }
+      continue;
+    }
+
+    // '<' can't appear unescaped in attribute values, so every remaining '<' starts a tag
+    if (position + 2 + nameSize < size && data[position + 1] == '/' && memcmp(data + position + 2, name, nameSize) == 0) {
+
+      const char nameTerminator = data[position + 2 + nameSize];
+
+      if (nameTerminator == '>' || IsXmlWhitespace(nameTerminator)) {
+        XmlTag endTag;
+        return ReadTag(endTag);
+      }
+    }
+
+    position++;
+  }
+
+  SetError(QString("unterminated element at offset %1").arg(theStartTag.begin));
+  return false;
+}
+
+Utf8View XmlScanner::ReadElementContent(const XmlTag& theStartTag) {
+
+  if (theStartTag.closing || theStartTag.selfClosing) {
+    return Utf8View(data + theStartTag.end, 0);
+  }
+
+  int depth = 1;
+  XmlTag currTag;
+
+  while (depth > 0 && ReadNextTag(currTag)) {
+
+    if (currTag.closing) {
+      depth--;
+    }
+    else if (!currTag.selfClosing) {
+      depth++;
+    }
+  }
+
+  if (depth != 0) {
+    return Utf8View();
+  }
+
+  return Utf8View(data + theStartTag.end, static_cast<int>(currTag.begin - theStartTag.end));
+}
+
+QString XmlScanner::ReadElementText(const XmlTag& theStartTag) {
+
+  if (theStartTag.closing || theStartTag.selfClosing) {
+    return QString();
+  }
+
+  QString text;
+  int depth = 1;
+
+  while (depth > 0 && position < size) {
+
+    const char* tagStart = static_cast<const char*>(memchr(data + position, '<', size - position));
+    if (tagStart == nullptr) {
+      SetError(QString("unterminated element at offset %1").arg(theStartTag.begin));
+      break;
+    }
+
+    // text segments are decoded individually so that cdata content is never entity-unescaped
+    if (tagStart > data + position) {
+      text.append(Utf8View(data + position, static_cast<int>(tagStart - (data + position))).ToString());
+    }
+
+    position = tagStart - data;
+
+    if (HasPrefix("<![CDATA[", 9)) {
+
+      const qint64 cdataBegin = position + 9;
+      if (!SkipPast("]]>", 3)) {
+        break;
+      }
+      text.append(QString::fromUtf8(data + cdataBegin, static_cast<int>(position - 3 - cdataBegin)));
+      continue;
+    }
+
+    if (position + 1 < size && (data[position + 1] == '!' || data[position + 1] == '?')) {
+      if (!SkipMarkup()) {
+        break;
+      }
+      continue;
+    }
+
+    XmlTag currTag;
+    if (!ReadTag(currTag)) {
+      break;
+    }
+
+    if (currTag.closing) {
+      depth--;
+    }
+    else if (!currTag.selfClosing) {
+      depth++;
+    }
+  }
+
+  return text;
+}
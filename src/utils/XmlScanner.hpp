@@ -0,0 +1,106 @@
+//
+//  XmlScanner.hpp
+//  sparkless
+//
+//  Created by Kyle King on 2020-03-14.
+//  Copyright © 2020 Kyle King. All rights reserved.
+//
+
+#ifndef XmlScanner_hpp
+#define XmlScanner_hpp
+
+#include <QString>
+
+#include "utils/Utf8View.hpp"
+
+// a single start/end tag located by XmlScanner. All views point into the scanned buffer.
+struct XmlTag {
+
+  Utf8View name;
+  Utf8View attributes;
+
+  qint64 begin = -1;
+  qint64 end = -1;
+
+  bool closing = false;
+  bool selfClosing = false;
+
+  Utf8View Attribute(const char* theName) const;
+  bool HasAttribute(const char* theName) const { return !Attribute(theName).IsNull(); }
+};
+
+// minimal forward-only tag scanner for appcast xml. Unlike QXmlStreamReader it never decodes or copies
+// the underlying utf-8 bytes, which lets callers keep views into (e.g.) a memory-mapped file.
+class XmlScanner {
+
+private:
+
+  const char* data = nullptr;
+  qint64 size = 0;
+  qint64 position = 0;
+
+  QString errorString;
+
+
+#pragma mark - Constructors -
+
+#pragma mark Public
+public:
+
+  XmlScanner(const char* theData, const qint64 theSize);
+
+
+#pragma mark - Accessors -
+
+#pragma mark Private
+private:
+
+  bool HasPrefix(const char* thePrefix, const int thePrefixSize) const;
+
+#pragma mark Public
+public:
+
+  const char* Data() const { return data; }
+  qint64 Size() const { return size; }
+  qint64 Position() const { return position; }
+
+  bool AtEnd() const { return position >= size; }
+  bool HasError() const { return !errorString.isNull(); }
+  const QString& ErrorString() const { return errorString; }
+
+
+#pragma mark - Mutators -
+
+#pragma mark Private
+private:
+
+  bool SkipPast(const char* theTerminator, const int theTerminatorSize);
+  bool SkipMarkup();
+  bool ReadTag(XmlTag& theTag);
+  void SetError(const QString&);
+
+#pragma mark Public
+public:
+
+  void Seek(const qint64 thePosition);
+
+  // reads the next start or end tag, skipping text, comments, processing instructions, doctypes and cdata
+  bool ReadNextTag(XmlTag& theTag);
+
+  // mirrors QXmlStreamReader::readNextStartElement() - returns false once the enclosing element's end tag is consumed
+  bool ReadNextStartTag(XmlTag& theTag);
+
+  // consumes everything up to and including the end tag matching theStartTag
+  bool SkipElement(const XmlTag& theStartTag);
+
+  // faster SkipElement() for elements that never contain an element of the same name - only tag starts are
+  // inspected, attributes and nested tags aren't parsed
+  bool SkipUnnestedElement(const XmlTag& theStartTag);
+  QString ReadElementText(const XmlTag& theStartTag);
+
+  // like ReadElementText() but returns the undecoded bytes between the start and end tags
+  Utf8View ReadElementContent(const XmlTag& theStartTag);
+
+};
+
+#endif /* XmlScanner_hpp */